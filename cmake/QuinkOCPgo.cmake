@@ -0,0 +1,111 @@
+# Profile-guided optimization of the plugins
+#
+# QUINK_OC_PGO selects the stage:
+#   OFF       plain build
+#   GENERATE  instrumented plugins; the quink_oc_pgo_train target runs
+#             quink_oc_bench over the workloads in tools/CMakeLists.txt and
+#             leaves the profile in QUINK_OC_PGO_DIR
+#   USE       build with the profile in QUINK_OC_PGO_DIR
+#   ON        both: an instrumented build is configured, built and trained
+#             under pgo-generate/ as a dependency of the plugins, which are
+#             then compiled with its profile. Training runs once; remove
+#             pgo-generate/ from the build tree to retrain.
+#
+# Only plugin and kernel objects are instrumented, not the tools.
+
+set(QUINK_OC_PGO OFF CACHE STRING "Profile-guided optimization: OFF, ON, GENERATE or USE")
+set_property(CACHE QUINK_OC_PGO PROPERTY STRINGS OFF ON GENERATE USE)
+set(QUINK_OC_PGO_DIR "${CMAKE_BINARY_DIR}/pgo-data" CACHE PATH "Profile data directory")
+
+set(QUINK_OC_PGO_COMPILE_OPTIONS "")
+set(QUINK_OC_PGO_LINK_OPTIONS "")
+set(QUINK_OC_PGO_DEPENDS "")
+
+# Apply the stage's flags to a plugin, kernel object or bundle target
+function(quink_oc_enable_pgo target)
+    target_compile_options(${target} PRIVATE ${QUINK_OC_PGO_COMPILE_OPTIONS})
+    target_link_options(${target} PRIVATE ${QUINK_OC_PGO_LINK_OPTIONS})
+    if(QUINK_OC_PGO_DEPENDS)
+        add_dependencies(${target} ${QUINK_OC_PGO_DEPENDS})
+    endif()
+endfunction()
+
+if(NOT QUINK_OC_PGO)
+    return()
+endif()
+
+if(NOT CMAKE_CXX_COMPILER_ID MATCHES "GNU|Clang")
+    message(WARNING "QUINK_OC_PGO is only supported with GCC and Clang, ignored")
+    return()
+endif()
+
+if(CMAKE_CXX_COMPILER_ID MATCHES "Clang")
+    string(REGEX MATCH "^[0-9]+" _clang_major "${CMAKE_CXX_COMPILER_VERSION}")
+    get_filename_component(_clang_dir "${CMAKE_CXX_COMPILER}" DIRECTORY)
+    find_program(QUINK_OC_LLVM_PROFDATA
+        NAMES llvm-profdata llvm-profdata-${_clang_major}
+        HINTS ${_clang_dir})
+    if(NOT QUINK_OC_LLVM_PROFDATA)
+        message(FATAL_ERROR "QUINK_OC_PGO with Clang needs llvm-profdata")
+    endif()
+    set(QUINK_OC_PGO_PROFILE "${QUINK_OC_PGO_DIR}/quink_oc.profdata")
+endif()
+
+if(QUINK_OC_PGO STREQUAL "GENERATE")
+    if(CMAKE_CXX_COMPILER_ID STREQUAL "GNU")
+        # The prefix path makes .gcda names relative to the build tree, so a
+        # build in another directory finds them. Plugins run parallel_for_,
+        # hence atomic counters.
+        set(QUINK_OC_PGO_COMPILE_OPTIONS
+            -fprofile-generate=${QUINK_OC_PGO_DIR}
+            -fprofile-prefix-path=${CMAKE_BINARY_DIR}
+            -fprofile-update=atomic)
+        set(QUINK_OC_PGO_LINK_OPTIONS -fprofile-generate=${QUINK_OC_PGO_DIR})
+    else()
+        set(QUINK_OC_PGO_COMPILE_OPTIONS
+            -fprofile-generate=${QUINK_OC_PGO_DIR}/raw
+            -fprofile-update=atomic)
+        set(QUINK_OC_PGO_LINK_OPTIONS -fprofile-generate=${QUINK_OC_PGO_DIR}/raw)
+    endif()
+    return()
+endif()
+
+if(QUINK_OC_PGO STREQUAL "ON")
+    include(ExternalProject)
+    ExternalProject_Add(quink_oc_pgo_generate
+        SOURCE_DIR ${CMAKE_SOURCE_DIR}
+        BINARY_DIR ${CMAKE_BINARY_DIR}/pgo-generate
+        CMAKE_ARGS
+            -DQUINK_OC_PGO=GENERATE
+            -DQUINK_OC_PGO_DIR=${QUINK_OC_PGO_DIR}
+            -DCMAKE_BUILD_TYPE=${CMAKE_BUILD_TYPE}
+            -DCMAKE_CXX_COMPILER=${CMAKE_CXX_COMPILER}
+            -DOpenCV_DIR=${OpenCV_DIR}
+            -DQUINK_OC_CPU_DISPATCH=${QUINK_OC_CPU_DISPATCH}
+            -DQUINK_OC_BUILD_BUNDLE=${QUINK_OC_BUILD_BUNDLE}
+            -DQUINK_OC_LTO=${QUINK_OC_LTO}
+            -DQUINK_OC_STATIC_OPENCV=${QUINK_OC_STATIC_OPENCV}
+        BUILD_COMMAND ${CMAKE_COMMAND} --build <BINARY_DIR> --target quink_oc_pgo_train
+        BUILD_BYPRODUCTS ${QUINK_OC_PGO_PROFILE}
+        INSTALL_COMMAND ""
+        EXCLUDE_FROM_ALL ON)
+    set(QUINK_OC_PGO_DEPENDS quink_oc_pgo_generate)
+elseif(NOT QUINK_OC_PGO STREQUAL "USE")
+    message(FATAL_ERROR "QUINK_OC_PGO must be OFF, ON, GENERATE or USE")
+endif()
+
+# Stale or partial profiles must not fail the build, the affected
+# functions are just optimized without them.
+if(CMAKE_CXX_COMPILER_ID STREQUAL "GNU")
+    set(QUINK_OC_PGO_COMPILE_OPTIONS
+        -fprofile-use=${QUINK_OC_PGO_DIR}
+        -fprofile-prefix-path=${CMAKE_BINARY_DIR}
+        -fprofile-partial-training
+        -Wno-missing-profile
+        -Wno-coverage-mismatch)
+else()
+    set(QUINK_OC_PGO_COMPILE_OPTIONS
+        -fprofile-use=${QUINK_OC_PGO_PROFILE}
+        -Wno-profile-instr-unprofiled
+        -Wno-profile-instr-out-of-date)
+endif()
@@ -0,0 +1,153 @@
+/*
+ * Asynchronous adapter
+ *
+ * Wraps a plugin class, stateful or not, and runs it on a dedicated worker
+ * thread so the host's filter thread only hands frames over:
+ *
+ *     QUINK_OC_PLUGIN_ENTRY(QuinkOCAsync<AvgPlugin>, "avgframes", "...")
+ *
+ * "async=N" in the plugin parameters enables it with up to N frames queued
+ * for the worker (the wrapped plugin sees the same string and must ignore
+ * the key); without it every call goes straight to the plugin.
+ *
+ * This is a single-stage QuinkOCPipeline: process() copies the inputs into a
+ * free queue slot, blocking only when N frames are already queued, and
+ * returns the oldest finished frame set if there is one, TRY_AGAIN
+ * otherwise. Frames keep their order; flush() waits for the worker to finish
+ * the queue and flush the plugin, and hands back the rest one by one. The
+ * input copy is needed because host frames are only valid during the call,
+ * unless the host retains them for N frames plus the plugin's own lookahead
+ * (QuinkOCPlugin::retain_inputs()), in which case the queue holds the host
+ * frames themselves.
+ */
+
+#ifndef QUINK_OC_ASYNC_H
+#define QUINK_OC_ASYNC_H
+
+#include <quink_oc_plugin.h>
+#include <quink_oc_pipeline.h>
+#include <cstdlib>
+#include <cstring>
+
+template <class Plugin>
+class QuinkOCAsync : public QuinkOCPlugin {
+public:
+    ~QuinkOCAsync() override { pipeline_.stop(); }
+
+    bool init(const char *params, int nb_inputs, int nb_outputs) override {
+        depth_ = 0;
+        const char *pos = params ? strstr(params, "async=") : nullptr;
+        if (pos) {
+            depth_ = atoi(pos + 6);
+            if (depth_ < 0)
+                depth_ = 0;
+            if (depth_ > kMaxDepth)
+                depth_ = kMaxDepth;
+        }
+        return plugin_.init(params, nb_inputs, nb_outputs);
+    }
+
+    QuinkOCProcessResult process(const std::vector<cv::Mat> &inputs,
+                                 std::vector<cv::Mat> &outputs) override {
+        if (depth_ == 0)
+            return plugin_.process(inputs, outputs);
+        return pipeline_.process(inputs, outputs);
+    }
+
+    bool flush(std::vector<cv::Mat> &outputs) override {
+        if (depth_ == 0)
+            return plugin_.flush(outputs);
+        return pipeline_.flush(outputs);
+    }
+
+    bool configure(const std::vector<QuinkOCFrameConfig> &inputs,
+                   std::vector<QuinkOCFrameConfig> &outputs) override {
+        pipeline_.stop();
+        if (!plugin_.configure(inputs, outputs))
+            return false;
+        if (depth_ == 0 || inputs.empty())
+            return true;
+
+        // Outputs keep the pixel format of the input they default to
+        std::vector<QuinkOCFrameConfig> configs(outputs);
+        for (size_t k = 0; k < configs.size(); k++)
+            configs[k].cv_type = inputs[k < inputs.size() ? k : 0].cv_type;
+        pipeline_.start({{&plugin_, configs, plugin_.frame_layout(), true, plugin_.proxy_scale()}},
+                        inputs, depth_, borrow_);
+        return true;
+    }
+
+    void uninit() override {
+        pipeline_.stop();
+        plugin_.uninit();
+    }
+
+    int row_halo() const override { return depth_ == 0 ? plugin_.row_halo() : -1; }
+
+    QuinkOCFrameLayout frame_layout() const override { return plugin_.frame_layout(); }
+
+    void process_batch(const std::vector<std::vector<cv::Mat>> &inputs,
+                       std::vector<std::vector<cv::Mat>> &outputs,
+                       std::vector<QuinkOCProcessResult> &results) override {
+        if (depth_ == 0)
+            plugin_.process_batch(inputs, outputs, results);
+        else
+            QuinkOCPlugin::process_batch(inputs, outputs, results);
+    }
+
+    void warmup(const std::vector<QuinkOCFrameConfig> &inputs,
+                const std::vector<QuinkOCFrameConfig> &outputs) override {
+        plugin_.warmup(inputs, outputs);
+        if (depth_ > 0)
+            pipeline_.warmup();
+    }
+
+    // The pipeline resets the plugin between its frames
+    bool reset() override {
+        if (depth_ == 0)
+            return plugin_.reset();
+        return pipeline_.reset();
+    }
+
+    // Frames queued for the worker aren't in the plugin's state, so only a
+    // direct plugin saves. Before the first frame the worker is idle.
+    bool save_state(std::vector<uint8_t> &blob) override { return depth_ == 0 && plugin_.save_state(blob); }
+
+    bool load_state(const void *data, size_t size) override { return plugin_.load_state(data, size); }
+
+    // Queued plugins get their proxies built on the worker thread
+    int proxy_scale() const override { return depth_ == 0 ? plugin_.proxy_scale() : 0; }
+
+    void output_metadata(std::vector<QuinkOCMetadataEntry> &entries) override {
+        if (depth_ == 0)
+            plugin_.output_metadata(entries);
+        else
+            pipeline_.output_metadata(entries);
+    }
+
+    // A frame is done with depth calls after it was queued, then kept by the plugin
+    int input_lookahead() const override { return depth_ + plugin_.input_lookahead(); }
+
+    void retain_inputs(int depth) override {
+        borrow_ = depth_ > 0 && depth >= input_lookahead();
+        if (depth_ == 0)
+            plugin_.retain_inputs(depth);
+        else
+            plugin_.retain_inputs(borrow_ ? depth - depth_ : 0);
+    }
+
+    void process_rows(const std::vector<cv::Mat> &inputs, std::vector<cv::Mat> &outputs,
+                      int y0, int y1) override {
+        plugin_.process_rows(inputs, outputs, y0, y1);
+    }
+
+private:
+    static constexpr int kMaxDepth = 16;
+
+    Plugin plugin_;
+    int depth_ = 0;  ///< Frames queued for the worker, 0 to call the plugin directly
+    bool borrow_ = false;  ///< Host retains its frames, queue them without copying
+    QuinkOCPipeline pipeline_;
+};
+
+#endif /* QUINK_OC_ASYNC_H */
@@ -0,0 +1,185 @@
+/*
+ * Analysis cadence adapter
+ *
+ * Wraps an analysis plugin, one whose outputs are its inputs passed through
+ * with results in output_metadata(), and runs it on some frames only:
+ *
+ *     QUINK_OC_PLUGIN_ENTRY(QuinkOCCadence<ScenePlugin>, "scene", "...")
+ *
+ * "every=N" in the plugin parameters processes one frame in N and
+ * "interval=MS" one frame per MS milliseconds of steady clock time, which
+ * suits live sources; with both, whichever comes first. Frames in between
+ * are passed through without a copy, with no metadata or, with
+ * "repeat_metadata=1", that of the last processed frame. The plugin can
+ * have the next frame processed regardless by returning true from
+ * process_next(). The wrapped plugin sees the same string and must ignore
+ * the keys; without them every frame is processed.
+ *
+ * The plugin must output each frame in the call that takes it, and its
+ * outputs must be configured like the inputs they pass through. Batches
+ * (process_batch()) are always processed in full.
+ */
+
+#ifndef QUINK_OC_CADENCE_H
+#define QUINK_OC_CADENCE_H
+
+#include <quink_oc_plugin.h>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+template <class Plugin>
+class QuinkOCCadence : public QuinkOCPlugin {
+public:
+    bool init(const char *params, int nb_inputs, int nb_outputs) override {
+        every_ = 0;
+        interval_ms_ = 0;
+        repeat_ = false;
+        const char *pos = params ? strstr(params, "every=") : nullptr;
+        if (pos) {
+            every_ = atoi(pos + 6);
+            if (every_ < 0)
+                every_ = 0;
+        }
+        pos = params ? strstr(params, "interval=") : nullptr;
+        if (pos) {
+            interval_ms_ = atoi(pos + 9);
+            if (interval_ms_ < 0)
+                interval_ms_ = 0;
+        }
+        pos = params ? strstr(params, "repeat_metadata=") : nullptr;
+        if (pos)
+            repeat_ = atoi(pos + 16) != 0;
+        nb_inputs_ = nb_inputs;
+        return plugin_.init(params, nb_inputs, nb_outputs);
+    }
+
+    QuinkOCProcessResult process(const std::vector<cv::Mat> &inputs,
+                                 std::vector<cv::Mat> &outputs) override {
+        const Clock::time_point now = Clock::now();
+        if (!due(now)) {
+            for (size_t k = 0; k < outputs.size(); k++)
+                outputs[k] = inputs[k < static_cast<size_t>(nb_inputs_) ? k : 0];
+            skipped_++;
+            passed_ = true;
+            return QUINK_OC_OK;
+        }
+
+        QuinkOCProcessResult ret = plugin_.process(inputs, outputs);
+        started_ = true;
+        last_ = now;
+        skipped_ = 0;
+        passed_ = false;
+        metadata_.clear();
+        if (ret == QUINK_OC_OK)
+            plugin_.output_metadata(metadata_);
+        forced_ = plugin_.process_next();
+        return ret;
+    }
+
+    bool flush(std::vector<cv::Mat> &outputs) override {
+        if (!plugin_.flush(outputs))
+            return false;
+        passed_ = false;
+        metadata_.clear();
+        plugin_.output_metadata(metadata_);
+        return true;
+    }
+
+    bool configure(const std::vector<QuinkOCFrameConfig> &inputs,
+                   std::vector<QuinkOCFrameConfig> &outputs) override {
+        if (!plugin_.configure(inputs, outputs))
+            return false;
+
+        // Skipped frames go out as the inputs they default to
+        if (every_ > 1 || interval_ms_ > 0) {
+            for (size_t k = 0; k < outputs.size(); k++) {
+                const QuinkOCFrameConfig &in = inputs[k < inputs.size() ? k : 0];
+                if (outputs[k].width != in.width || outputs[k].height != in.height)
+                    return false;
+            }
+        }
+        startOver();
+        return true;
+    }
+
+    void uninit() override { plugin_.uninit(); }
+
+    void output_metadata(std::vector<QuinkOCMetadataEntry> &entries) override {
+        if (!passed_ || repeat_)
+            entries.insert(entries.end(), metadata_.begin(), metadata_.end());
+    }
+
+    void process_batch(const std::vector<std::vector<cv::Mat>> &inputs,
+                       std::vector<std::vector<cv::Mat>> &outputs,
+                       std::vector<QuinkOCProcessResult> &results) override {
+        plugin_.process_batch(inputs, outputs, results);
+    }
+
+    void warmup(const std::vector<QuinkOCFrameConfig> &inputs,
+                const std::vector<QuinkOCFrameConfig> &outputs) override {
+        plugin_.warmup(inputs, outputs);
+    }
+
+    bool reset() override {
+        startOver();
+        return plugin_.reset();
+    }
+
+    bool save_state(std::vector<uint8_t> &blob) override { return plugin_.save_state(blob); }
+
+    // The cadence starts over: the first frame after loading is processed
+    bool load_state(const void *data, size_t size) override {
+        if (!plugin_.load_state(data, size))
+            return false;
+        startOver();
+        return true;
+    }
+
+    int input_lookahead() const override { return plugin_.input_lookahead(); }
+
+    void retain_inputs(int depth) override { plugin_.retain_inputs(depth); }
+
+    QuinkOCFrameLayout frame_layout() const override { return plugin_.frame_layout(); }
+
+    // Proxies would be built for skipped frames too; the plugin makes its own
+    int proxy_scale() const override { return every_ > 1 || interval_ms_ > 0 ? 0 : plugin_.proxy_scale(); }
+
+    bool process_next() const override { return plugin_.process_next(); }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    /** Process the next frame, with nothing to repeat */
+    void startOver() {
+        started_ = false;
+        forced_ = false;
+        passed_ = false;
+        skipped_ = 0;
+        last_ = Clock::time_point();
+        metadata_.clear();
+    }
+
+    /** Whether the frame arriving at now goes to the plugin */
+    bool due(Clock::time_point now) const {
+        if (!started_ || forced_ || (every_ <= 1 && interval_ms_ <= 0))
+            return true;
+        if (every_ > 1 && skipped_ + 1 >= every_)
+            return true;
+        return interval_ms_ > 0 && now - last_ >= std::chrono::milliseconds(interval_ms_);
+    }
+
+    Plugin plugin_;
+    int nb_inputs_ = 1;
+    int every_ = 0;        ///< Frames per processed frame, 0 for no frame count
+    int interval_ms_ = 0;  ///< Time between processed frames, 0 for no interval
+    bool repeat_ = false;  ///< Passed frames get the last processed frame's metadata
+    bool started_ = false;
+    bool forced_ = false;  ///< The plugin asked for the next frame
+    bool passed_ = false;  ///< The last frame out was passed through
+    int skipped_ = 0;      ///< Frames passed through since the last processed one
+    Clock::time_point last_;
+    std::vector<QuinkOCMetadataEntry> metadata_;  ///< Of the last processed frame
+};
+
+#endif /* QUINK_OC_CADENCE_H */
@@ -0,0 +1,322 @@
+/*
+ * Frame-parallel adapter for stateless plugins
+ *
+ * Wraps a plugin class that keeps no state between frames and runs K
+ * instances of it on worker threads, one frame per instance, so K frames are
+ * processed at once without any host change:
+ *
+ *     QUINK_OC_PLUGIN_ENTRY(QuinkOCFrameParallel<BlurPlugin>, "blur", "...")
+ *
+ * K comes from "frame_threads=K" in the plugin parameters (the wrapped
+ * plugin sees the same string and must ignore the key). With the default of
+ * 1 every call goes straight to a single instance, so wrapping a plugin
+ * changes nothing until frame threads are asked for.
+ *
+ * Frame n goes to instance n % K. process() copies the inputs into that
+ * instance's slot and starts it; once K frames are in flight it waits for
+ * the oldest and returns it. The first K - 1 calls return TRY_AGAIN, outputs
+ * keep their input order, and flush() hands back the frames still in flight.
+ * Inputs are copied unless the host retains them for K - 1 calls
+ * (QuinkOCPlugin::retain_inputs()).
+ */
+
+#ifndef QUINK_OC_FRAME_PARALLEL_H
+#define QUINK_OC_FRAME_PARALLEL_H
+
+#include <quink_oc_plugin.h>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+template <class Plugin>
+class QuinkOCFrameParallel : public QuinkOCPlugin {
+public:
+    ~QuinkOCFrameParallel() override { uninit(); }
+
+    bool init(const char *params, int nb_inputs, int nb_outputs) override {
+        uninit();
+        int threads = 1;
+        const char *pos = params ? strstr(params, "frame_threads=") : nullptr;
+        if (pos)
+            threads = atoi(pos + 14);
+        if (threads < 1)
+            threads = 1;
+        if (threads > kMaxThreads)
+            threads = kMaxThreads;
+
+        for (int i = 0; i < threads; i++) {
+            std::unique_ptr<Worker> w(new Worker);
+            if (!w->plugin.init(params, nb_inputs, nb_outputs))
+                return false;
+            w->initialized = true;
+            workers_.push_back(std::move(w));
+        }
+        return true;
+    }
+
+    QuinkOCProcessResult process(const std::vector<cv::Mat> &inputs,
+                                 std::vector<cv::Mat> &outputs) override {
+        if (workers_.size() == 1)
+            return workers_[0]->plugin.process(inputs, outputs);
+        if (failed_)
+            return QUINK_OC_ERROR;
+
+        // At most K - 1 frames are in flight between calls, so this slot is free
+        Worker &w = *workers_[submitted_ % workers_.size()];
+        w.inputs.resize(inputs.size());
+        for (size_t k = 0; k < inputs.size(); k++) {
+            if (borrow_)
+                w.inputs[k] = inputs[k];
+            else
+                inputs[k].copyTo(w.inputs[k]);
+        }
+        {
+            std::lock_guard<std::mutex> lock(w.mutex);
+            w.state = Worker::kQueued;
+        }
+        w.cond.notify_all();
+        submitted_++;
+
+        if (submitted_ - collected_ < workers_.size())
+            return QUINK_OC_TRY_AGAIN;
+        return collect(*workers_[collected_ % workers_.size()], outputs);
+    }
+
+    bool flush(std::vector<cv::Mat> &outputs) override {
+        if (workers_.size() == 1)
+            return workers_[0]->plugin.flush(outputs);
+        while (!failed_ && collected_ < submitted_) {
+            QuinkOCProcessResult ret = collect(*workers_[collected_ % workers_.size()], outputs);
+            if (ret == QUINK_OC_OK)
+                return true;
+            if (ret == QUINK_OC_ERROR)
+                return false;
+        }
+        // Stateless plugins have nothing left, but honour the contract
+        while (!failed_ && flush_worker_ < workers_.size()) {
+            Plugin &plugin = workers_[flush_worker_]->plugin;
+            if (plugin.flush(outputs)) {
+                metadata_.clear();
+                plugin.output_metadata(metadata_);
+                return true;
+            }
+            flush_worker_++;
+        }
+        return false;
+    }
+
+    bool configure(const std::vector<QuinkOCFrameConfig> &inputs,
+                   std::vector<QuinkOCFrameConfig> &outputs) override {
+        if (workers_.empty())
+            return false;
+        stopThreads();
+        for (size_t i = 0; i < workers_.size(); i++) {
+            std::vector<QuinkOCFrameConfig> out(outputs);
+            if (!workers_[i]->plugin.configure(inputs, out))
+                return false;
+            if (i == 0)
+                configs_ = out;
+        }
+        outputs = configs_;
+
+        submitted_ = collected_ = 0;
+        flush_worker_ = 0;
+        metadata_.clear();
+        failed_ = false;
+        if (workers_.size() > 1) {
+            const QuinkOCFrameLayout layout = frame_layout();
+            for (std::unique_ptr<Worker> &w : workers_) {
+                w->buffers.clear();
+                for (size_t k = 0; k < configs_.size(); k++) {
+                    const int type = k < inputs.size() ? inputs[k].cv_type : inputs[0].cv_type;
+                    w->buffers.push_back(quink_oc_alloc_frame(configs_[k].height, configs_[k].width,
+                                                              type, layout));
+                }
+                w->inputs.clear();
+                for (const QuinkOCFrameConfig &in : inputs)
+                    w->inputs.push_back(quink_oc_alloc_frame(in.height, in.width, in.cv_type, layout));
+                w->state = Worker::kIdle;
+                w->thread = std::thread(&QuinkOCFrameParallel::run, this, w.get());
+            }
+        }
+        return true;
+    }
+
+    void uninit() override {
+        stopThreads();
+        for (std::unique_ptr<Worker> &w : workers_) {
+            if (w->initialized)
+                w->plugin.uninit();
+        }
+        workers_.clear();
+    }
+
+    // Rows don't depend on the frame's instance, so any instance can fuse
+    int row_halo() const override { return workers_.empty() ? -1 : workers_[0]->plugin.row_halo(); }
+
+    void process_rows(const std::vector<cv::Mat> &inputs, std::vector<cv::Mat> &outputs,
+                      int y0, int y1) override {
+        workers_[0]->plugin.process_rows(inputs, outputs, y0, y1);
+    }
+
+    QuinkOCFrameLayout frame_layout() const override {
+        return workers_.empty() ? QuinkOCFrameLayout{1, 0} : workers_[0]->plugin.frame_layout();
+    }
+
+    // Hosts batch instead of calling process(), so no frames are in flight and
+    // the first instance can take the batch on the host's thread
+    void process_batch(const std::vector<std::vector<cv::Mat>> &inputs,
+                       std::vector<std::vector<cv::Mat>> &outputs,
+                       std::vector<QuinkOCProcessResult> &results) override {
+        workers_[0]->plugin.process_batch(inputs, outputs, results);
+    }
+
+    // Proxies are inputs like any other, copied or borrowed with them
+    int proxy_scale() const override { return workers_.empty() ? 0 : workers_[0]->plugin.proxy_scale(); }
+
+    void output_metadata(std::vector<QuinkOCMetadataEntry> &entries) override {
+        if (workers_.size() == 1) {
+            workers_[0]->plugin.output_metadata(entries);
+            return;
+        }
+        entries.insert(entries.end(), metadata_.begin(), metadata_.end());
+        metadata_.clear();
+    }
+
+    void warmup(const std::vector<QuinkOCFrameConfig> &inputs,
+                const std::vector<QuinkOCFrameConfig> &outputs) override {
+        for (std::unique_ptr<Worker> &w : workers_) {
+            w->plugin.warmup(inputs, outputs);
+            for (cv::Mat &frame : w->buffers)
+                frame.setTo(cv::Scalar::all(0));
+            if (!borrow_) {
+                for (cv::Mat &frame : w->inputs)
+                    frame.setTo(cv::Scalar::all(0));
+            }
+        }
+    }
+
+    // Frames in flight are finished and dropped; the threads keep running
+    bool reset() override {
+        for (std::unique_ptr<Worker> &w : workers_) {
+            std::unique_lock<std::mutex> lock(w->mutex);
+            w->cond.wait(lock, [&w] { return w->state != Worker::kQueued; });
+            if (w->state == Worker::kDone)
+                w->state = Worker::kIdle;
+        }
+        submitted_ = collected_ = 0;
+        flush_worker_ = 0;
+        metadata_.clear();
+        failed_ = false;
+        for (std::unique_ptr<Worker> &w : workers_) {
+            if (!w->plugin.reset())
+                return false;
+        }
+        return !workers_.empty();
+    }
+
+    // Instances keep no state, but frames are in flight between calls
+    bool save_state(std::vector<uint8_t> &blob) override {
+        return workers_.size() == 1 && workers_[0]->plugin.save_state(blob);
+    }
+
+    bool load_state(const void *data, size_t size) override {
+        return workers_.size() == 1 && workers_[0]->plugin.load_state(data, size);
+    }
+
+    // Frame n is collected by call n + K - 1
+    int input_lookahead() const override {
+        if (workers_.size() > 1)
+            return static_cast<int>(workers_.size()) - 1;
+        return workers_.empty() ? 0 : workers_[0]->plugin.input_lookahead();
+    }
+
+    void retain_inputs(int depth) override {
+        if (workers_.size() == 1)
+            workers_[0]->plugin.retain_inputs(depth);
+        borrow_ = workers_.size() > 1 && depth >= input_lookahead();
+    }
+
+private:
+    static constexpr int kMaxThreads = 64;
+
+    struct Worker {
+        enum State { kIdle, kQueued, kDone, kStop };
+
+        Plugin plugin;
+        bool initialized = false;
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable cond;
+        State state = kIdle;
+        QuinkOCProcessResult result = QUINK_OC_OK;
+        std::vector<cv::Mat> inputs;   ///< Copies, or the host's frames when retained
+        std::vector<cv::Mat> buffers;  ///< Output frames
+        std::vector<cv::Mat> written;  ///< What the plugin wrote: buffers or pass-through
+        std::vector<QuinkOCMetadataEntry> metadata;  ///< Of written
+    };
+
+    void run(Worker *w) {
+        std::unique_lock<std::mutex> lock(w->mutex);
+        for (;;) {
+            w->cond.wait(lock, [w] { return w->state == Worker::kQueued || w->state == Worker::kStop; });
+            if (w->state == Worker::kStop)
+                return;
+            lock.unlock();
+            w->written = w->buffers;
+            QuinkOCProcessResult ret = w->plugin.process(w->inputs, w->written);
+            w->metadata.clear();
+            if (ret == QUINK_OC_OK)
+                w->plugin.output_metadata(w->metadata);
+            lock.lock();
+            w->result = ret;
+            w->state = Worker::kDone;
+            w->cond.notify_all();
+        }
+    }
+
+    /** Wait for the worker's frame and copy it out, OK/TRY_AGAIN/ERROR as the plugin returned */
+    QuinkOCProcessResult collect(Worker &w, std::vector<cv::Mat> &outputs) {
+        std::unique_lock<std::mutex> lock(w.mutex);
+        w.cond.wait(lock, [&w] { return w.state == Worker::kDone; });
+        w.state = Worker::kIdle;
+        collected_++;
+        if (w.result == QUINK_OC_ERROR)
+            failed_ = true;
+        if (w.result != QUINK_OC_OK)
+            return w.result;
+        for (size_t k = 0; k < outputs.size() && k < w.written.size(); k++)
+            w.written[k].copyTo(outputs[k]);
+        metadata_ = std::move(w.metadata);
+        return QUINK_OC_OK;
+    }
+
+    void stopThreads() {
+        for (std::unique_ptr<Worker> &w : workers_) {
+            if (!w->thread.joinable())
+                continue;
+            {
+                std::unique_lock<std::mutex> lock(w->mutex);
+                w->cond.wait(lock, [&w] { return w->state != Worker::kQueued; });
+                w->state = Worker::kStop;
+            }
+            w->cond.notify_all();
+            w->thread.join();
+        }
+    }
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<QuinkOCFrameConfig> configs_;
+    std::vector<QuinkOCMetadataEntry> metadata_;  ///< Of the frame set last returned
+    size_t submitted_ = 0;     ///< Frames handed to workers
+    size_t collected_ = 0;     ///< Frames taken back, in submission order
+    size_t flush_worker_ = 0;  ///< Next instance to flush after the drain
+    bool failed_ = false;
+    bool borrow_ = false;      ///< Host retains inputs until they are collected
+};
+
+#endif /* QUINK_OC_FRAME_PARALLEL_H */
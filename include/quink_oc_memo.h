@@ -0,0 +1,238 @@
+/*
+ * Output memoization for pure plugins
+ *
+ * Looped content (slates, bumpers, idle screens) sends identical frames
+ * through the same plugin again and again. For plugins whose descriptor has
+ * QUINK_OC_PLUGIN_FLAG_PURE a host can key the outputs by a hash of the
+ * inputs and reuse them:
+ *
+ *     if (!memo.lookup(inputs, outputs)) {
+ *         if (plugin->process(inputs, outputs) == QUINK_OC_OK)
+ *             memo.store(outputs);
+ *     }
+ *
+ * The hash is 128 bits over the frames' geometry and pixels, seeded with the
+ * plugin parameters; pixels are consumed 128 bytes at a time by 32
+ * independent 32-bit lanes, which compilers turn into SIMD multiply-rotate
+ * steps. Entries are evicted least recently used first.
+ */
+
+#ifndef QUINK_OC_MEMO_H
+#define QUINK_OC_MEMO_H
+
+#include <quink_oc_plugin.h>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+struct QuinkOCFrameHash {
+    uint64_t lo;
+    uint64_t hi;
+
+    bool operator==(const QuinkOCFrameHash &other) const { return lo == other.lo && hi == other.hi; }
+};
+
+/** Consumes blocks of kQuinkOCHashBlockBytes bytes into kQuinkOCHashLanes accumulators */
+typedef void (*QuinkOCHashBlocksFunc)(uint32_t *acc, const unsigned char *data, size_t blocks);
+
+static const int kQuinkOCHashLanes = 32;
+static const size_t kQuinkOCHashBlockBytes = kQuinkOCHashLanes * sizeof(uint32_t);
+
+/**
+ * xxHash32 rounds on 32 independent lanes
+ *
+ * Wide enough that compilers vectorize it (and keep several vectors in
+ * flight to hide the multiply latency). The result depends on the ISA the
+ * includer is compiled for only in speed; a host can pass its own
+ * runtime-dispatched variant of the same rounds (the chain plugin does).
+ */
+inline void quink_oc_hash_blocks(uint32_t *acc, const unsigned char *data, size_t blocks) {
+    uint32_t lanes[kQuinkOCHashLanes];
+    memcpy(lanes, acc, sizeof(lanes));
+    for (size_t b = 0; b < blocks; b++, data += kQuinkOCHashBlockBytes) {
+        for (int i = 0; i < kQuinkOCHashLanes; i++) {
+            uint32_t v;
+            memcpy(&v, data + i * sizeof(v), sizeof(v));
+            const uint32_t a = lanes[i] + v * 2246822519u;
+            lanes[i] = ((a << 13) | (a >> 19)) * 2654435761u;
+        }
+    }
+    memcpy(acc, lanes, sizeof(lanes));
+}
+
+/** Streaming 128-bit hash of frames */
+class QuinkOCFrameHasher {
+public:
+    explicit QuinkOCFrameHasher(uint64_t seed = 0, QuinkOCHashBlocksFunc blocks = quink_oc_hash_blocks)
+        : blocks_(blocks), length_(seed) {
+        for (int i = 0; i < kQuinkOCHashLanes; i++)
+            acc_[i] = static_cast<uint32_t>(seed >> (i & 1 ? 32 : 0)) + 2654435761u * (i + 1);
+    }
+
+    void update(const void *data, size_t size) {
+        const unsigned char *p = static_cast<const unsigned char *>(data);
+        const size_t blocks = size / kQuinkOCHashBlockBytes;
+        if (blocks)
+            blocks_(acc_, p, blocks);
+        const size_t tail = size - blocks * kQuinkOCHashBlockBytes;
+        if (tail) {
+            unsigned char block[kQuinkOCHashBlockBytes] = {};
+            memcpy(block, p + blocks * kQuinkOCHashBlockBytes, tail);
+            block[kQuinkOCHashBlockBytes - 1] ^= static_cast<unsigned char>(tail);
+            quink_oc_hash_blocks(acc_, block, 1);
+        }
+        length_ += size;
+    }
+
+    void update(const cv::Mat &frame) {
+        const int header[4] = {frame.rows, frame.cols, frame.type(), 0};
+        update(header, sizeof(header));
+        const size_t row_bytes = frame.cols * frame.elemSize();
+        if (frame.isContinuous()) {
+            update(frame.data, row_bytes * frame.rows);
+            return;
+        }
+        for (int y = 0; y < frame.rows; y++)
+            update(frame.ptr(y), row_bytes);
+    }
+
+    QuinkOCFrameHash digest() const {
+        uint64_t lo = length_ ^ 0x9e3779b97f4a7c15ull;
+        uint64_t hi = ~length_;
+        for (int i = 0; i < kQuinkOCHashLanes; i++) {
+            lo = mix(lo ^ acc_[i]);
+            hi = mix(hi + acc_[kQuinkOCHashLanes - 1 - i] * 0xc2b2ae3d27d4eb4full);
+        }
+        return {lo, hi};
+    }
+
+private:
+    /** splitmix64 finalizer */
+    static uint64_t mix(uint64_t x) {
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+        return x ^ (x >> 31);
+    }
+
+    QuinkOCHashBlocksFunc blocks_;
+    uint32_t acc_[kQuinkOCHashLanes];
+    uint64_t length_;
+};
+
+/** Bounded LRU of output frame sets keyed by the input hash */
+class QuinkOCMemoCache {
+public:
+    /**
+     * @param capacity  frame sets kept, 0 disables the cache
+     * @param params    plugin parameters, part of every key
+     * @param blocks    hash rounds, e.g. a variant for the CPU's best ISA
+     * @param layout    row layout of the cached frames, for hosts that hand
+     *                  them on to plugins with a frame_layout()
+     */
+    explicit QuinkOCMemoCache(size_t capacity = 8, const char *params = nullptr,
+                              QuinkOCHashBlocksFunc blocks = quink_oc_hash_blocks,
+                              QuinkOCFrameLayout layout = {1, 0})
+        : capacity_(capacity), blocks_(blocks), layout_(layout) {
+        QuinkOCFrameHasher hasher;
+        if (params)
+            hasher.update(params, strlen(params));
+        seed_ = hasher.digest().lo;
+    }
+
+    /**
+     * Look up the outputs for inputs
+     *
+     * On a hit outputs are replaced by headers sharing the cached frames,
+     * which must not be written to; a host that needs its own buffers copies
+     * them, and metadata, if given, gets the plugin's output_metadata() stored
+     * with them. On a miss the key is kept for the next store().
+     */
+    bool lookup(const std::vector<cv::Mat> &inputs, std::vector<cv::Mat> &outputs,
+                std::vector<QuinkOCMetadataEntry> *metadata = nullptr) {
+        if (capacity_ == 0)
+            return false;
+        QuinkOCFrameHasher hasher(seed_, blocks_);
+        for (const cv::Mat &in : inputs)
+            hasher.update(in);
+        pending_ = hasher.digest();
+        have_pending_ = true;
+        tick_++;
+
+        for (Entry &e : entries_) {
+            if (!(e.key == pending_) || e.outputs.size() < outputs.size())
+                continue;
+            e.used = tick_;
+            for (size_t k = 0; k < outputs.size(); k++)
+                outputs[k] = e.outputs[k];
+            if (metadata)
+                metadata->insert(metadata->end(), e.metadata.begin(), e.metadata.end());
+            have_pending_ = false;
+            hits_++;
+            return true;
+        }
+        misses_++;
+        return false;
+    }
+
+    /** Remember the outputs computed after the last lookup() miss, and their metadata */
+    void store(const std::vector<cv::Mat> &outputs,
+               const std::vector<QuinkOCMetadataEntry> *metadata = nullptr) {
+        if (!have_pending_)
+            return;
+        have_pending_ = false;
+
+        Entry *slot = nullptr;
+        if (entries_.size() < capacity_) {
+            entries_.emplace_back();
+            slot = &entries_.back();
+        } else {
+            slot = &entries_[0];
+            for (Entry &e : entries_) {
+                if (e.used < slot->used)
+                    slot = &e;
+            }
+        }
+        // Fresh frames rather than copies into the old ones, which may still
+        // be referenced by outputs handed out on an earlier hit
+        slot->key = pending_;
+        slot->used = tick_;
+        slot->outputs.clear();
+        for (const cv::Mat &out : outputs) {
+            slot->outputs.push_back(quink_oc_alloc_frame(out.rows, out.cols, out.type(), layout_));
+            out.copyTo(slot->outputs.back());
+        }
+        if (metadata)
+            slot->metadata = *metadata;
+        else
+            slot->metadata.clear();
+    }
+
+    void clear() {
+        entries_.clear();
+        have_pending_ = false;
+    }
+
+    size_t hits() const { return hits_; }
+    size_t misses() const { return misses_; }
+
+private:
+    struct Entry {
+        QuinkOCFrameHash key = {0, 0};
+        uint64_t used = 0;
+        std::vector<cv::Mat> outputs;
+        std::vector<QuinkOCMetadataEntry> metadata;
+    };
+
+    size_t capacity_;
+    QuinkOCHashBlocksFunc blocks_;
+    QuinkOCFrameLayout layout_;
+    uint64_t seed_ = 0;
+    std::vector<Entry> entries_;
+    QuinkOCFrameHash pending_ = {0, 0};
+    bool have_pending_ = false;
+    uint64_t tick_ = 0;
+    size_t hits_ = 0;
+    size_t misses_ = 0;
+};
+
+#endif /* QUINK_OC_MEMO_H */
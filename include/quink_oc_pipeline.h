@@ -0,0 +1,470 @@
+/*
+ * Pipeline-parallel execution of plugin stages
+ *
+ * Every stage runs on its own thread. Consecutive stages are connected by a
+ * link: a pool of frame slots (one cv::Mat per output of the producer) and
+ * two bounded lock-free single-producer single-consumer queues of slot
+ * indices, one carrying filled slots forward and one returning free slots.
+ * A producer waits for a free slot, which is the backpressure; the first link
+ * is filled by the host thread and the last one drained by it. Used by the
+ * chain plugin and, with a single stage, by QuinkOCAsync.
+ *
+ * Ordering follows from the FIFO queues. At end of stream an end marker
+ * travels down the links; each stage flushes, forwarding what it produces,
+ * before passing the marker on, the same order the synchronous chain uses.
+ * Metadata of output frames (QuinkOCPlugin::output_metadata()) travels in
+ * the slots with the frames. Luma proxies a stage asks for are built on the
+ * stage's thread.
+ */
+
+#ifndef QUINK_OC_PIPELINE_H
+#define QUINK_OC_PIPELINE_H
+
+#include <quink_oc_plugin.h>
+#include <quink_oc_proxy.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Bounded lock-free SPSC ring of ints
+ *
+ * Push and pop never take a lock. Blocking variants spin briefly, then sleep
+ * on a condition variable that the other side only touches when a waiter is
+ * registered.
+ */
+class QuinkOCSpscQueue {
+public:
+    explicit QuinkOCSpscQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity + 1)
+            size <<= 1;
+        ring_.reset(new int[size]);
+        mask_ = size - 1;
+    }
+
+    bool tryPush(int value) {
+        if (!pushNoWake(value))
+            return false;
+        wake();
+        return true;
+    }
+
+    bool tryPop(int &value) {
+        if (!popNoWake(value))
+            return false;
+        wake();
+        return true;
+    }
+
+    void push(int value) {
+        wait([&] { return pushNoWake(value); });
+        wake();
+    }
+
+    int pop() {
+        int value = 0;
+        wait([&] { return popNoWake(value); });
+        wake();
+        return value;
+    }
+
+private:
+    bool pushNoWake(int value) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        const size_t next = (tail + 1) & mask_;
+        if (next == head_.load(std::memory_order_acquire))
+            return false;
+        ring_[tail] = value;
+        tail_.store(next, std::memory_order_seq_cst);
+        return true;
+    }
+
+    bool popNoWake(int &value) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire))
+            return false;
+        value = ring_[head];
+        head_.store((head + 1) & mask_, std::memory_order_seq_cst);
+        return true;
+    }
+
+    template <typename Try>
+    void wait(Try attempt) {
+        for (int i = 0; i < 256; i++) {
+            if (attempt())
+                return;
+        }
+        waiters_.fetch_add(1, std::memory_order_seq_cst);
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!attempt())
+            cond_.wait(lock);
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void wake() {
+        if (waiters_.load(std::memory_order_seq_cst) == 0)
+            return;
+        { std::lock_guard<std::mutex> lock(mutex_); }
+        cond_.notify_all();
+    }
+
+    std::unique_ptr<int[]> ring_;
+    size_t mask_ = 0;
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+    alignas(64) std::atomic<int> waiters_{0};
+    std::mutex mutex_;
+    std::condition_variable cond_;
+};
+
+/**
+ * Metadata of the frames passing through a stage
+ *
+ * Entries of every frame set a stage takes in wait here until the stage
+ * outputs that frame set, one out per in as with lookahead, and then move
+ * to its outputs: input k's to output k, or to output 0 if there are fewer
+ * outputs, as frame configurations default. The stage's own entries for
+ * the frames follow them.
+ */
+class QuinkOCMetadataCarrier {
+public:
+    /** Entries of the frame set just handed to the stage */
+    void push(std::vector<QuinkOCMetadataEntry> entries) {
+        // Frames a stage drops keep theirs waiting; don't let them pile up
+        if (pending_.size() >= kMaxPending)
+            pending_.pop_front();
+        pending_.push_back(std::move(entries));
+    }
+
+    /** Entries for the frame set the stage just output, with nb_outputs outputs */
+    std::vector<QuinkOCMetadataEntry> pop(int nb_outputs) {
+        std::vector<QuinkOCMetadataEntry> entries;
+        if (pending_.empty())
+            return entries;
+        entries = std::move(pending_.front());
+        pending_.pop_front();
+        for (QuinkOCMetadataEntry &e : entries) {
+            if (e.output >= nb_outputs)
+                e.output = 0;
+        }
+        return entries;
+    }
+
+    void clear() { pending_.clear(); }
+
+private:
+    static constexpr size_t kMaxPending = 1024;
+
+    std::deque<std::vector<QuinkOCMetadataEntry>> pending_;
+};
+
+struct QuinkOCPipelineStage {
+    QuinkOCPlugin *plugin;
+    std::vector<QuinkOCFrameConfig> outputs;  ///< Configured outputs, cv_type included
+    QuinkOCFrameLayout layout;  ///< The plugin's frame_layout(), zero for none
+    bool metadata;              ///< The plugin has output_metadata(), API level 7
+    int proxy_scale;            ///< Luma proxies the pipeline appends to its inputs, 0 for none
+};
+
+class QuinkOCPipeline {
+public:
+    ~QuinkOCPipeline() { stop(); }
+
+    /**
+     * Allocate the links and start one thread per stage
+     *
+     * @param inputs  configuration of the host frames fed to the first stage
+     * @param depth   slots per link, i.e. frames in flight between two stages
+     * @param borrow  the host retains its frames for depth plus the first
+     *                stage's input_lookahead() calls (see retain_inputs()),
+     *                so the first link holds them instead of copies
+     */
+    void start(const std::vector<QuinkOCPipelineStage> &stages,
+               const std::vector<QuinkOCFrameConfig> &inputs, int depth, bool borrow = false) {
+        stop();
+        stages_ = stages;
+        links_.clear();
+        for (size_t i = 0; i <= stages_.size(); i++) {
+            const std::vector<QuinkOCFrameConfig> &cfg = i == 0 ? inputs : stages_[i - 1].outputs;
+            // Slots are written by one stage and read by the next
+            QuinkOCFrameLayout layout = {1, 0};
+            if (i > 0)
+                layout = quink_oc_merge_layout(layout, stages_[i - 1].layout);
+            if (i < stages_.size())
+                layout = quink_oc_merge_layout(layout, stages_[i].layout);
+            links_.emplace_back(new Link(cfg, depth, i == 0 && borrow, layout));
+        }
+        borrow_ = borrow;
+        error_ = false;
+        eos_sent_ = false;
+        for (size_t i = 0; i < stages_.size(); i++)
+            threads_.emplace_back(&QuinkOCPipeline::run, this, i);
+    }
+
+    /** Hand a frame set to the first stage and return one finished frame set if there is one */
+    QuinkOCProcessResult process(const std::vector<cv::Mat> &inputs, std::vector<cv::Mat> &outputs) {
+        if (error_ || eos_sent_)
+            return QUINK_OC_ERROR;
+
+        // Drain before feeding: the host is the only consumer of the last
+        // link, so blocking on a free input slot first could deadlock.
+        bool produced = false;
+        int slot = 0;
+        Link &last = *links_.back();
+        if (last.filled.tryPop(slot)) {
+            if (slot == kError)
+                return QUINK_OC_ERROR;
+            copyOut(last, slot, outputs);
+            produced = true;
+        }
+
+        Link &first = *links_.front();
+        slot = first.free.pop();
+        first.metadata[slot].clear();
+        for (size_t k = 0; k < first.slots[slot].size() && k < inputs.size(); k++) {
+            if (borrow_)
+                first.slots[slot][k] = inputs[k];
+            else
+                inputs[k].copyTo(first.slots[slot][k]);
+        }
+        first.filled.push(slot);
+        return produced ? QUINK_OC_OK : QUINK_OC_TRY_AGAIN;
+    }
+
+    /** Wait for the next finished frame set after end of stream; false once all are out */
+    bool flush(std::vector<cv::Mat> &outputs) {
+        if (threads_.empty())
+            return false;
+        if (!eos_sent_) {
+            links_.front()->filled.push(kEndOfStream);
+            eos_sent_ = true;
+        }
+
+        Link &last = *links_.back();
+        for (;;) {
+            int slot = last.filled.pop();
+            if (slot == kEndOfStream) {
+                join();
+                return false;
+            }
+            if (slot == kError)
+                continue;  // Stages drain to the end marker after an error
+            copyOut(last, slot, outputs);
+            return true;
+        }
+    }
+
+    bool failed() const { return error_; }
+
+    /** Write every slot the pipeline allocated, before the first process(), so frames don't fault them in */
+    void warmup() {
+        for (size_t i = borrow_ ? 1 : 0; i < links_.size(); i++) {
+            for (std::vector<cv::Mat> &slot : links_[i]->slots) {
+                for (cv::Mat &frame : slot)
+                    frame.setTo(cv::Scalar::all(0));
+            }
+        }
+    }
+
+    /** Append the metadata of the frame set last returned by process() or flush() */
+    void output_metadata(std::vector<QuinkOCMetadataEntry> &entries) {
+        entries.insert(entries.end(), metadata_.begin(), metadata_.end());
+        metadata_.clear();
+    }
+
+    /**
+     * Drop the frames in flight and start again on a new stream
+     *
+     * The frames are finished and discarded, every stage's plugin is reset
+     * (QuinkOCPlugin::reset(), which they must have) and the threads start
+     * again on the same links, so nothing is allocated.
+     *
+     * @return false if a plugin can't be reset; the pipeline is then stopped
+     */
+    bool reset() {
+        stop();
+        for (const QuinkOCPipelineStage &stage : stages_) {
+            if (!stage.plugin->reset())
+                return false;
+        }
+        // Slots still held by a stage when it stopped are free again
+        int slot = 0;
+        for (size_t i = 0; i < links_.size(); i++) {
+            Link &link = *links_[i];
+            while (link.filled.tryPop(slot)) {}
+            while (link.free.tryPop(slot)) {}
+            for (size_t s = 0; s < link.slots.size(); s++) {
+                if (i == 0 && borrow_) {
+                    for (cv::Mat &frame : link.slots[s])
+                        frame.release();
+                }
+                link.metadata[s].clear();
+                link.free.push(static_cast<int>(s));
+            }
+        }
+        metadata_.clear();
+        error_ = false;
+        eos_sent_ = false;
+        for (size_t i = 0; i < stages_.size(); i++)
+            threads_.emplace_back(&QuinkOCPipeline::run, this, i);
+        return true;
+    }
+
+    /** Stop the threads, flushing whatever is still in flight */
+    void stop() {
+        if (threads_.empty())
+            return;
+        if (!eos_sent_) {
+            links_.front()->filled.push(kEndOfStream);
+            eos_sent_ = true;
+        }
+        Link &last = *links_.back();
+        for (;;) {
+            int slot = last.filled.pop();
+            if (slot == kEndOfStream)
+                break;
+            if (slot != kError)
+                last.free.push(slot);
+        }
+        join();
+    }
+
+private:
+    static constexpr int kEndOfStream = -1;
+    static constexpr int kError = -2;
+
+    struct Link {
+        Link(const std::vector<QuinkOCFrameConfig> &cfg, int depth, bool borrowed,
+             const QuinkOCFrameLayout &layout)
+            : filled(depth + 2), free(depth) {
+            slots.resize(depth);
+            metadata.resize(depth);
+            for (int s = 0; s < depth; s++) {
+                slots[s].resize(cfg.size());
+                for (size_t k = 0; k < cfg.size() && !borrowed; k++)
+                    slots[s][k] = quink_oc_alloc_frame(cfg[k].height, cfg[k].width, cfg[k].cv_type, layout);
+                free.push(s);
+            }
+        }
+
+        std::vector<std::vector<cv::Mat>> slots;
+        std::vector<std::vector<QuinkOCMetadataEntry>> metadata;  ///< Per slot
+        QuinkOCSpscQueue filled;  ///< Producer to consumer, also carries the markers
+        QuinkOCSpscQueue free;    ///< Consumer back to producer
+    };
+
+    void copyOut(Link &link, int slot, std::vector<cv::Mat> &outputs) {
+        for (size_t k = 0; k < outputs.size() && k < link.slots[slot].size(); k++)
+            link.slots[slot][k].copyTo(outputs[k]);
+        metadata_ = std::move(link.metadata[slot]);
+        link.free.push(slot);
+    }
+
+    /** Frames a stage passed through still belong to its input slot; copy them into its own */
+    static void settle(std::vector<cv::Mat> &written, std::vector<cv::Mat> &slot) {
+        for (size_t k = 0; k < written.size(); k++) {
+            if (written[k].data != slot[k].data)
+                written[k].copyTo(slot[k]);
+        }
+    }
+
+    void run(size_t index) {
+        const QuinkOCPipelineStage &stage = stages_[index];
+        QuinkOCPlugin *plugin = stage.plugin;
+        Link &in = *links_[index];
+        Link &out = *links_[index + 1];
+        bool failed = false;
+        int held = -1;  // Output slot acquired but not filled yet
+        std::vector<cv::Mat> written;
+        QuinkOCMetadataCarrier carrier;
+        std::vector<QuinkOCProxyPyramid> pyramids(stage.proxy_scale > 0 ? in.slots[0].size() : 0);
+        std::vector<cv::Mat> proxied;  // Inputs and their proxies
+
+        // Entries of the frames just written to the held slot
+        auto describe = [&]() {
+            out.metadata[held] = carrier.pop(static_cast<int>(stage.outputs.size()));
+            if (stage.metadata)
+                plugin->output_metadata(out.metadata[held]);
+        };
+
+        auto acquire = [&]() {
+            if (held < 0)
+                held = out.free.pop();
+            written = out.slots[held];
+        };
+
+        for (;;) {
+            const int slot = in.filled.pop();
+            if (slot == kEndOfStream)
+                break;
+            if (slot == kError) {
+                failed = true;
+                continue;
+            }
+            if (failed) {
+                in.free.push(slot);
+                continue;
+            }
+
+            acquire();
+            carrier.push(std::move(in.metadata[slot]));
+            const std::vector<cv::Mat> *inputs = &in.slots[slot];
+            if (!pyramids.empty()) {
+                proxied = *inputs;
+                for (size_t k = 0; k < pyramids.size(); k++) {
+                    pyramids[k].set((*inputs)[k]);
+                    proxied.push_back(pyramids[k].level(stage.proxy_scale));
+                }
+                inputs = &proxied;
+            }
+            QuinkOCProcessResult ret = plugin->process(*inputs, written);
+            if (ret == QUINK_OC_OK) {
+                settle(written, out.slots[held]);
+                describe();
+            }
+            in.free.push(slot);
+
+            if (ret == QUINK_OC_OK) {
+                out.filled.push(held);
+                held = -1;
+            } else if (ret == QUINK_OC_ERROR) {
+                failed = true;
+                error_ = true;
+                out.filled.push(kError);
+            }
+        }
+
+        while (!failed) {
+            acquire();
+            if (!plugin->flush(written))
+                break;
+            settle(written, out.slots[held]);
+            describe();
+            out.filled.push(held);
+            held = -1;
+        }
+        // A slot still held is dropped; links are rebuilt by the next start() or reset()
+        out.filled.push(kEndOfStream);
+    }
+
+    void join() {
+        for (std::thread &t : threads_)
+            t.join();
+        threads_.clear();
+    }
+
+    std::vector<QuinkOCPipelineStage> stages_;
+    std::vector<std::unique_ptr<Link>> links_;
+    std::vector<std::thread> threads_;
+    std::atomic<bool> error_{false};
+    std::vector<QuinkOCMetadataEntry> metadata_;  ///< Of the frame set last returned
+    bool eos_sent_ = false;
+    bool borrow_ = false;  ///< First link slots are headers of retained host frames
+};
+
+#endif /* QUINK_OC_PIPELINE_H */
@@ -24,9 +24,38 @@
 #define AVFILTER_QUINK_OC_PLUGIN_H
 
 #include <opencv2/core.hpp>
+#include <cstdint>
+#include <cstring>
+#include <string>
 #include <vector>
 
+/**
+ * API levels
+ *
+ *   1  initial interface
+ *   2  row_halo() / process_rows() for stage fusion
+ *   3  QuinkOCPluginDescriptor::flags
+ *   4  input_lookahead() / retain_inputs() for retained input frames
+ *   5  frame_layout() for row alignment and padding
+ *   6  process_batch() for several streams in one call
+ *   7  output_metadata() for results attached to output frames
+ *   8  proxy_scale() for downscaled luma inputs
+ *   9  process_next() for hosts that skip frames
+ *  10  warmup() before the first frame
+ *  11  reset() for reuse on a new stream
+ *  12  save_state() / load_state() for handing a stream over
+ *
+ * Every level only appends virtual methods and descriptor fields, so the
+ * descriptor's api_version stays QUINK_OC_PLUGIN_API_VERSION, which hosts
+ * written against the initial interface require. A library reports the
+ * level its plugins were built with from quink_oc_plugin_get_api_level();
+ * libraries without that symbol are level 1. A method or descriptor field
+ * added in level N may only be used on plugins of level >= N; older
+ * plugins don't have it in their vtable or descriptor. Hosts treat plugins
+ * of a higher level than their own as their own level.
+ */
 #define QUINK_OC_PLUGIN_API_VERSION 1
+#define QUINK_OC_PLUGIN_API_LEVEL 12
 
 /**
  * Supported I/O modes:
@@ -41,9 +70,91 @@
 struct QuinkOCFrameConfig {
     int width;
     int height;
-    int cv_type;     ///< OpenCV type (e.g., CV_8UC3), ignored for output
+    int cv_type;     ///< OpenCV type (e.g., CV_8UC3); for outputs only set by the host for warmup()
 };
 
+/**
+ * Row layout of a frame's memory (API level 5)
+ *
+ * Kept apart from QuinkOCFrameConfig, whose size plugins built against
+ * older versions of this header depend on.
+ */
+struct QuinkOCFrameLayout {
+    int row_align;   ///< Power of two; the first row and the row step are multiples of it
+    int row_padding; ///< Bytes past the end of every row that can be read, and written in outputs
+};
+
+/**
+ * Result attached to an output frame (API level 7)
+ *
+ * Hosts map text entries to the frame's metadata dictionary and binary ones
+ * to frame side data, so analysis results travel with the frame.
+ */
+struct QuinkOCMetadataEntry {
+    int output;         ///< Index of the output frame
+    std::string key;    ///< e.g. "lavfi.quink.scene.score"
+    std::string value;  ///< Text, or the bytes of binary side data
+    bool binary;        ///< Side data rather than a metadata string
+};
+
+/** Whether frame's memory has at least layout's alignment and padding */
+inline bool quink_oc_frame_has_layout(const cv::Mat &frame, const QuinkOCFrameLayout &layout) {
+    if (frame.empty())
+        return false;
+    const size_t align = layout.row_align > 1 ? layout.row_align : 1;
+    const size_t row_bytes = frame.cols * frame.elemSize();
+    const size_t padding = layout.row_padding > 0 ? layout.row_padding : 0;
+    return reinterpret_cast<uintptr_t>(frame.data) % align == 0 && frame.step[0] % align == 0 &&
+           (frame.rows == 1 || frame.step[0] >= row_bytes + padding) &&
+           frame.ptr(frame.rows - 1) + row_bytes + padding <= frame.datalimit;
+}
+
+/**
+ * Allocate a frame with layout's alignment and padding
+ *
+ * Without requirements this is a plain continuous cv::Mat. Otherwise the
+ * frame is a view into a wider block, so it owns its memory like any other
+ * cv::Mat and copyTo() into it keeps the layout.
+ */
+inline cv::Mat quink_oc_alloc_frame(int rows, int cols, int type, const QuinkOCFrameLayout &layout) {
+    if (layout.row_align <= 1 && layout.row_padding <= 0)
+        return cv::Mat(rows, cols, type);
+
+    const int esz1 = static_cast<int>(CV_ELEM_SIZE1(type));
+    const int cn = CV_MAT_CN(type);
+    int align = esz1;
+    while (align < layout.row_align)
+        align <<= 1;
+    const size_t row_bytes = static_cast<size_t>(cols) * esz1 * cn;
+    const size_t padding = layout.row_padding > 0 ? layout.row_padding : 0;
+    // One alignment unit more per row leaves room to move the start to an
+    // aligned address
+    const size_t step = cv::alignSize(row_bytes + padding, align) + align;
+    cv::Mat block(rows, static_cast<int>(step / esz1), CV_MAKETYPE(CV_MAT_DEPTH(type), 1));
+    const int offset = static_cast<int>(cv::alignPtr(block.data, align) - block.data);
+    return block(cv::Rect(offset / esz1, 0, cols * cn, rows)).reshape(cn);
+}
+
+/**
+ * Configuration of the luma proxy of an input at a downscale factor
+ *
+ * One channel of the input's depth, the size divided by scale and at least
+ * 8x8, as hosts build it for QuinkOCPlugin::proxy_scale().
+ */
+inline QuinkOCFrameConfig quink_oc_proxy_config(const QuinkOCFrameConfig &input, int scale) {
+    if (scale < 1)
+        scale = 1;
+    const int width = input.width / scale;
+    const int height = input.height / scale;
+    return {width > 8 ? width : 8, height > 8 ? height : 8, CV_MAKETYPE(CV_MAT_DEPTH(input.cv_type), 1)};
+}
+
+/** Layout meeting both a and b */
+inline QuinkOCFrameLayout quink_oc_merge_layout(const QuinkOCFrameLayout &a, const QuinkOCFrameLayout &b) {
+    return {a.row_align > b.row_align ? a.row_align : b.row_align,
+            a.row_padding > b.row_padding ? a.row_padding : b.row_padding};
+}
+
 enum QuinkOCProcessResult {
     QUINK_OC_OK = 0,              ///< Success, output frame(s) produced
     QUINK_OC_TRY_AGAIN = 1,       ///< Success, but output not ready yet
@@ -76,7 +187,8 @@ public:
      *   - output = input.clone() (defeats zero-copy, use copyTo instead)
      *   - output.create(...) or any reallocation
      *
-     * @param inputs   Input cv::Mat images (zero-copy from FFmpeg, refcount tied to AVFrame)
+     * @param inputs   Input cv::Mat images (zero-copy from FFmpeg), only valid
+     *                 during the call unless retained, see retain_inputs()
      * @param outputs  Output cv::Mat images (pre-allocated buffer to write into)
      */
     virtual QuinkOCProcessResult process(const std::vector<cv::Mat> &inputs,
@@ -108,6 +220,239 @@ public:
     virtual bool configure(const std::vector<QuinkOCFrameConfig> &inputs,
                            std::vector<QuinkOCFrameConfig> &outputs) = 0;
     virtual void uninit() = 0;
+
+    /**
+     * Row form of the plugin for stage fusion (API level 2)
+     *
+     * A plugin whose output row y only depends on input rows y - halo to
+     * y + halo, with outputs as tall as the inputs and no state carried
+     * between frames, can return its halo here and implement process_rows().
+     * A chain then runs consecutive such stages tile by tile, so the
+     * intermediate rows are still in cache when the next stage reads them.
+     * Called after configure().
+     *
+     * @return rows needed above and below an output row, -1 if not fusable
+     */
+    virtual int row_halo() const { return -1; }
+
+    /**
+     * Compute output rows [y0, y1)
+     *
+     * Same result as process() for those rows. inputs are whole frames of
+     * which at least rows [y0 - halo, y1 + halo) are valid (clamped to the
+     * frame); outputs are whole frames, no pass-through or reallocation.
+     * With a halo of 0 it may be called concurrently for disjoint ranges.
+     */
+    virtual void process_rows(const std::vector<cv::Mat> &inputs,
+                              std::vector<cv::Mat> &outputs, int y0, int y1) {
+        (void)inputs;
+        (void)outputs;
+        (void)y0;
+        (void)y1;
+    }
+
+    /**
+     * Input frame sets the plugin keeps referencing (API level 4)
+     *
+     * Temporal plugins that look at earlier frames return how many further
+     * process() calls they need an input to outlive, e.g. 2 for a plugin
+     * that reads frames n - 2 to n when producing output n. Called after
+     * init(); the host answers with retain_inputs().
+     *
+     * @return lookahead in frames, 0 if inputs are not kept
+     */
+    virtual int input_lookahead() const { return 0; }
+
+    /**
+     * Host's answer to input_lookahead(), called after init() and before configure()
+     *
+     * With depth > 0 the host keeps the frames it passed to a process() call
+     * unchanged until depth further process() calls have returned, and the
+     * last ones until flush() has returned false or configure(), reset() or
+     * uninit() has returned, so the plugin may hold cv::Mat headers of its inputs
+     * instead of copying them. The frames are read-only. depth may be lower
+     * than asked for, and hosts that never call this retain nothing, so
+     * plugins must copy whatever they keep beyond depth calls.
+     */
+    virtual void retain_inputs(int depth) { (void)depth; }
+
+    /**
+     * Row alignment and padding the plugin's kernels need (API level 5)
+     *
+     * Called after configure(). The host then only passes frames with at
+     * least this layout (see quink_oc_frame_has_layout()) as inputs and
+     * outputs of process(), flush() and process_rows(), allocating its own
+     * with quink_oc_alloc_frame() and copying input frames that fall short,
+     * so kernels can run whole vectors past the row end without a scalar
+     * tail. Frames a plugin allocates itself are up to the plugin.
+     *
+     * @return requirements, {1, 0} (the default) for none
+     */
+    virtual QuinkOCFrameLayout frame_layout() const { return {1, 0}; }
+
+    /**
+     * Process one frame set of each of several streams (API level 6)
+     *
+     * For hosts running the same plugin with the same parameters and frame
+     * configuration on many streams. inputs[i] and outputs[i] are stream i's
+     * frame sets as process() takes them, and results[i] gets what process()
+     * would have returned. Only plugins flagged QUINK_OC_PLUGIN_FLAG_PURE are
+     * batched, since they keep nothing per stream, and a host uses either
+     * process() or process_batch() on an instance. The default processes the
+     * streams one after the other.
+     */
+    virtual void process_batch(const std::vector<std::vector<cv::Mat>> &inputs,
+                               std::vector<std::vector<cv::Mat>> &outputs,
+                               std::vector<QuinkOCProcessResult> &results) {
+        results.resize(inputs.size());
+        for (size_t i = 0; i < inputs.size(); i++)
+            results[i] = process(inputs[i], outputs[i]);
+    }
+
+    /**
+     * Metadata of the frames just produced (API level 7)
+     *
+     * Called by the host after every process() that returned QUINK_OC_OK and
+     * every flush() that returned true. The plugin appends entries for the
+     * output frames of that call, which may be passed through input frames;
+     * with lookahead they describe the delayed frame being output. Not
+     * called after process_batch(), whose streams share the instance.
+     */
+    virtual void output_metadata(std::vector<QuinkOCMetadataEntry> &entries) { (void)entries; }
+
+    /**
+     * Downscale factor of the luma proxies the plugin analyses (API level 8)
+     *
+     * Called after configure(). For a factor > 0 the host appends a proxy of
+     * every input to the inputs of process(): inputs[nb_inputs + k] is
+     * input k converted to gray and area-resized to quink_oc_proxy_config(),
+     * built once per frame and shared by all plugins on the stream (see
+     * quink_oc_proxy.h). Proxies are new frames every call and may be kept.
+     * Hosts that don't know the method pass none, so plugins build their own
+     * when inputs.size() == nb_inputs.
+     *
+     * @return downscale factor, 0 (the default) for no proxies
+     */
+    virtual int proxy_scale() const { return 0; }
+
+    /**
+     * Whether the next frame must be processed (API level 9)
+     *
+     * Hosts and adapters that run an analysis plugin on some frames only
+     * (see quink_oc_cadence.h) ask after every process() and don't skip the
+     * next frame if the answer is true, e.g. right after a scene change.
+     */
+    virtual bool process_next() const { return false; }
+
+    /**
+     * Get ready for the first frame (API level 10)
+     *
+     * Called by the host after configure() and before the first process(),
+     * where latency to the first output matters, with the configurations
+     * of configure(). The host fills in the outputs' cv_type with the pixel
+     * format it allocates them with. The plugin allocates and writes its
+     * scratch and ring buffers, so page faults don't land on the first
+     * frames, and may run its kernels once on dummy frames to get lazy
+     * initialization and thread pools going, leaving its state as
+     * configure() left it.
+     */
+    virtual void warmup(const std::vector<QuinkOCFrameConfig> &inputs,
+                        const std::vector<QuinkOCFrameConfig> &outputs) {
+        (void)inputs;
+        (void)outputs;
+    }
+
+    /**
+     * Start a new stream with the same parameters and configuration (API level 11)
+     *
+     * For hosts that keep instances across segments or streams instead of
+     * creating and configuring one for each. The plugin drops the frames it
+     * holds and the state it carries from frame to frame, as if configure()
+     * had just returned, but keeps its buffers and precomputed tables; the
+     * host then goes on with process() without calling configure(). Frames
+     * not flushed before are lost.
+     *
+     * @return true on success, false (the default) if the plugin can't be
+     *         reset and must be created again
+     */
+    virtual bool reset() { return false; }
+
+    /**
+     * Write the state carried from frame to frame (API level 12)
+     *
+     * Called between process() calls by hosts that checkpoint a stream so
+     * another process can take it over. The plugin appends what it needs
+     * to go on, the frames it holds included, to blob, formatted with
+     * QuinkOCStateWriter from quink_oc_state.h.
+     *
+     * @return true on success, false (the default) if the plugin can't save
+     *         its state
+     */
+    virtual bool save_state(std::vector<uint8_t> &blob) {
+        (void)blob;
+        return false;
+    }
+
+    /**
+     * Go on from a saved state (API level 12)
+     *
+     * Called after configure() and before the first process() with a blob
+     * from save_state() of an instance with the same parameters and
+     * configuration. The blob may be memory-mapped and is only valid during
+     * the call, so the plugin copies what it keeps. The next process()
+     * continues where the saved instance stopped, without warming up.
+     *
+     * @return false if the blob doesn't fit the instance, which is then left
+     *         as configure() left it
+     */
+    virtual bool load_state(const void *data, size_t size) {
+        (void)data;
+        (void)size;
+        return false;
+    }
+
+protected:
+    /**
+     * process_batch() as one parallel job over the streams
+     *
+     * For plugins whose process() may run concurrently on different frames.
+     * Each stream is processed on one thread, as OpenCV runs nested parallel
+     * regions serially; batches smaller than the thread count go stream by
+     * stream instead and leave the parallelism to OpenCV's own loops.
+     */
+    void process_batch_parallel(const std::vector<std::vector<cv::Mat>> &inputs,
+                                std::vector<std::vector<cv::Mat>> &outputs,
+                                std::vector<QuinkOCProcessResult> &results) {
+        const int count = static_cast<int>(inputs.size());
+        if (count < cv::getNumThreads()) {
+            QuinkOCPlugin::process_batch(inputs, outputs, results);
+            return;
+        }
+        results.resize(count);
+        cv::parallel_for_(cv::Range(0, count), [&](const cv::Range &range) {
+            for (int i = range.start; i < range.end; i++)
+                results[i] = process(inputs[i], outputs[i]);
+        }, count);
+    }
+
+    /**
+     * warmup() for plugins whose process() keeps no state
+     *
+     * Runs process() once on black frames with the configurations and the
+     * plugin's frame_layout(), as a host would allocate them.
+     */
+    void warmup_process(const std::vector<QuinkOCFrameConfig> &inputs,
+                        const std::vector<QuinkOCFrameConfig> &outputs) {
+        const QuinkOCFrameLayout layout = frame_layout();
+        std::vector<cv::Mat> in, out;
+        for (const QuinkOCFrameConfig &cfg : inputs) {
+            in.push_back(quink_oc_alloc_frame(cfg.height, cfg.width, cfg.cv_type, layout));
+            in.back().setTo(cv::Scalar::all(0));
+        }
+        for (const QuinkOCFrameConfig &cfg : outputs)
+            out.push_back(quink_oc_alloc_frame(cfg.height, cfg.width, cfg.cv_type, layout));
+        process(in, out);
+    }
 };
 
 /**
@@ -117,18 +462,54 @@ public:
  * Plugins export a single function that returns a pointer to a static descriptor.
  */
 struct QuinkOCPluginDescriptor {
-    int api_version;            ///< Must be QUINK_OC_PLUGIN_API_VERSION
+    int api_version;            ///< QUINK_OC_PLUGIN_API_VERSION, at every API level
     const char *name;           ///< Plugin name
     const char *description;    ///< Plugin description
 
     QuinkOCPlugin* (*create)();            ///< Create plugin instance
     void (*destroy)(QuinkOCPlugin* p);     ///< Destroy plugin instance
+
+    unsigned flags;             ///< QUINK_OC_PLUGIN_FLAG_*, API level 3
 };
 
+/**
+ * Outputs depend only on the current inputs and the parameters: no state
+ * carried between frames and no side effects, so equal inputs give equal
+ * outputs and a host may reuse earlier outputs (see quink_oc_memo.h). A
+ * process() returning TRY_AGAIN (e.g. with frame_threads) means the outputs
+ * are delayed and can't be keyed by the current inputs.
+ */
+#define QUINK_OC_PLUGIN_FLAG_PURE 0x1u
+
 typedef const QuinkOCPluginDescriptor* (*QuinkOCPluginGetDescriptorFunc)();
 
+/**
+ * Enumerate the descriptors of a library
+ *
+ * Returns the descriptor at index, or NULL past the last one. A single
+ * plugin library has one descriptor; a bundle library has one per plugin
+ * and does not export quink_oc_plugin_get_descriptor, so hosts pick a
+ * plugin by name.
+ */
+typedef const QuinkOCPluginDescriptor* (*QuinkOCPluginEnumDescriptorsFunc)(int index);
+
+/** QUINK_OC_PLUGIN_API_LEVEL the library's plugins were built with */
+typedef int (*QuinkOCPluginGetApiLevelFunc)();
+
 /** Symbol name to load from shared library */
 #define QUINK_OC_PLUGIN_DESCRIPTOR_SYMBOL "quink_oc_plugin_get_descriptor"
+#define QUINK_OC_PLUGIN_ENUM_SYMBOL "quink_oc_plugin_enum_descriptors"
+#define QUINK_OC_PLUGIN_LEVEL_SYMBOL "quink_oc_plugin_get_api_level"
+
+/** Find a descriptor by name through the enumeration entry point, NULL if absent */
+inline const QuinkOCPluginDescriptor *
+quink_oc_find_descriptor(QuinkOCPluginEnumDescriptorsFunc enum_descriptors, const char *name) {
+    for (int i = 0;; i++) {
+        const QuinkOCPluginDescriptor *desc = enum_descriptors(i);
+        if (!desc || !name || !strcmp(desc->name, name))
+            return desc;
+    }
+}
 
 #if defined(_WIN32) || defined(_WIN64)
     #define QUINK_OC_EXPORT __declspec(dllexport)
@@ -140,8 +521,30 @@ typedef const QuinkOCPluginDescriptor* (*QuinkOCPluginGetDescriptorFunc)();
  * Plugin entry macro
  *
  * Usage: QUINK_OC_PLUGIN_ENTRY(PluginClass, "name", "description")
+ *        QUINK_OC_PLUGIN_ENTRY_FLAGS(PluginClass, "name", "description", flags)
+ *
+ * When QUINK_OC_PLUGIN_BUNDLE is defined the plugin registers its descriptor
+ * with the bundle instead, which exports quink_oc_plugin_enum_descriptors()
+ * and quink_oc_plugin_get_api_level() for all plugins linked into it (see
+ * src/bundle.cpp).
  */
-#define QUINK_OC_PLUGIN_ENTRY(PluginClass, plugin_name, plugin_desc) \
+#ifdef QUINK_OC_PLUGIN_BUNDLE
+void quink_oc_bundle_register(const QuinkOCPluginDescriptor *desc);
+
+#define QUINK_OC_PLUGIN_ENTRY_FLAGS(PluginClass, plugin_name, plugin_desc, plugin_flags) \
+    static QuinkOCPlugin* _quink_create() { return new PluginClass(); } \
+    static void _quink_destroy(QuinkOCPlugin* p) { delete p; } \
+    static const QuinkOCPluginDescriptor _quink_desc = { \
+        QUINK_OC_PLUGIN_API_VERSION, \
+        plugin_name, \
+        plugin_desc, \
+        _quink_create, \
+        _quink_destroy, \
+        plugin_flags \
+    }; \
+    static const bool _quink_registered = (quink_oc_bundle_register(&_quink_desc), true);
+#else
+#define QUINK_OC_PLUGIN_ENTRY_FLAGS(PluginClass, plugin_name, plugin_desc, plugin_flags) \
     static QuinkOCPlugin* _quink_create() { return new PluginClass(); } \
     static void _quink_destroy(QuinkOCPlugin* p) { delete p; } \
     extern "C" QUINK_OC_EXPORT const QuinkOCPluginDescriptor* quink_oc_plugin_get_descriptor() { \
@@ -150,9 +553,18 @@ typedef const QuinkOCPluginDescriptor* (*QuinkOCPluginGetDescriptorFunc)();
             plugin_name, \
             plugin_desc, \
             _quink_create, \
-            _quink_destroy \
+            _quink_destroy, \
+            plugin_flags \
         }; \
         return &desc; \
-    }
+    } \
+    extern "C" QUINK_OC_EXPORT const QuinkOCPluginDescriptor* quink_oc_plugin_enum_descriptors(int index) { \
+        return index == 0 ? quink_oc_plugin_get_descriptor() : nullptr; \
+    } \
+    extern "C" QUINK_OC_EXPORT int quink_oc_plugin_get_api_level() { return QUINK_OC_PLUGIN_API_LEVEL; }
+#endif
+
+#define QUINK_OC_PLUGIN_ENTRY(PluginClass, plugin_name, plugin_desc) \
+    QUINK_OC_PLUGIN_ENTRY_FLAGS(PluginClass, plugin_name, plugin_desc, 0)
 
 #endif /* AVFILTER_QUINK_OC_PLUGIN_H */
@@ -0,0 +1,101 @@
+/*
+ * Downscaled luma proxies for analysis plugins
+ *
+ * Scene change, motion and crop detection only need a small gray version of
+ * the frame, which plugins ask for with QuinkOCPlugin::proxy_scale(). A host
+ * keeps one QuinkOCProxyPyramid per stream and points it at every new
+ * frame, so all plugins on the stream share the gray conversion and the
+ * downscales:
+ *
+ *     pyramid.set(frame);
+ *     for (plugin : plugins)
+ *         inputs.push_back(pyramid.level(plugin->proxy_scale()));
+ *
+ * Each level is resized from the coarsest level already built whose factor
+ * divides its own, so asking for 2 then 4 reads the full size luma once.
+ */
+
+#ifndef QUINK_OC_PROXY_H
+#define QUINK_OC_PROXY_H
+
+#include <quink_oc_plugin.h>
+#include <opencv2/imgproc.hpp>
+#include <vector>
+
+class QuinkOCProxyPyramid {
+public:
+    /** Build levels of frame from now on; the previous frame's are dropped */
+    void set(const cv::Mat &frame) {
+        frame_ = frame;
+        gray_.release();
+        levels_.clear();
+    }
+
+    /** Whether set() was last given frame, the same pixels at the same place */
+    bool holds(const cv::Mat &frame) const {
+        return frame.data == frame_.data && frame.size() == frame_.size() &&
+               frame.type() == frame_.type() && frame.step[0] == frame_.step[0];
+    }
+
+    /**
+     * The frame's luma proxy at a downscale factor, see quink_oc_proxy_config()
+     *
+     * Every level is a frame of its own, so callers may keep it after the
+     * next set().
+     */
+    cv::Mat level(int scale) {
+        if (scale < 1)
+            scale = 1;
+        const Level *base = nullptr;
+        for (const Level &l : levels_) {
+            if (l.scale == scale)
+                return l.proxy;
+            if (scale % l.scale == 0 && (!base || l.scale > base->scale))
+                base = &l;
+        }
+
+        const QuinkOCFrameConfig cfg = quink_oc_proxy_config({frame_.cols, frame_.rows, frame_.type()}, scale);
+        cv::Mat proxy;
+        if (scale == 1 && frame_.channels() == 1)
+            proxy = frame_.clone();
+        else if (scale == 1)
+            proxy = gray();
+        else
+            cv::resize(base ? base->proxy : gray(), proxy, cv::Size(cfg.width, cfg.height), 0, 0, cv::INTER_AREA);
+        levels_.push_back({scale, proxy});
+        return proxy;
+    }
+
+private:
+    struct Level {
+        int scale;
+        cv::Mat proxy;
+    };
+
+    /** Full size luma, the frame itself when it has one channel */
+    const cv::Mat &gray() {
+        if (!gray_.empty())
+            return gray_;
+        switch (frame_.channels()) {
+        case 1:
+            gray_ = frame_;
+            break;
+        case 3:
+            cv::cvtColor(frame_, gray_, cv::COLOR_BGR2GRAY);
+            break;
+        case 4:
+            cv::cvtColor(frame_, gray_, cv::COLOR_BGRA2GRAY);
+            break;
+        default:
+            cv::extractChannel(frame_, gray_, 0);
+            break;
+        }
+        return gray_;
+    }
+
+    cv::Mat frame_;
+    cv::Mat gray_;
+    std::vector<Level> levels_;
+};
+
+#endif /* QUINK_OC_PROXY_H */
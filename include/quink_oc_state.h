@@ -0,0 +1,138 @@
+/*
+ * Plugin state blobs
+ *
+ * QuinkOCPlugin::save_state() writes what a plugin carries from frame to
+ * frame into a flat blob and load_state() reads it back, so a standby
+ * process can take over a live stream where the failed one stopped:
+ *
+ *     QuinkOCStateWriter out(blob, "avgframes");
+ *     out.put<int32_t>(count);
+ *     out.putFrame(frame);
+ *
+ *     QuinkOCStateReader in(data, size, "avgframes");
+ *     if (!in.get(count) || !in.getFrame(frame) || !in.done())
+ *         return false;
+ *
+ * A blob starts with a magic number, the format version and the plugin
+ * name, followed by the plugin's values and frames back to back with no
+ * padding or pointers, so it can be written to a file and memory-mapped
+ * as it is. Values are in the machine's byte order; a blob from another
+ * byte order fails the magic check. Frames are stored as rows, columns and
+ * type followed by the pixels without row padding.
+ */
+
+#ifndef QUINK_OC_STATE_H
+#define QUINK_OC_STATE_H
+
+#include <quink_oc_plugin.h>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+class QuinkOCStateWriter {
+public:
+    QuinkOCStateWriter(std::vector<uint8_t> &blob, const char *name) : blob_(blob) {
+        put(kMagic);
+        put(kVersion);
+        const uint32_t len = static_cast<uint32_t>(strlen(name));
+        put(len);
+        putBytes(name, len);
+    }
+
+    template <typename T>
+    void put(const T &value) {
+        static_assert(std::is_trivially_copyable<T>::value, "state values are copied bytewise");
+        putBytes(&value, sizeof(value));
+    }
+
+    void putBytes(const void *data, size_t size) {
+        const uint8_t *p = static_cast<const uint8_t *>(data);
+        blob_.insert(blob_.end(), p, p + size);
+    }
+
+    void putFrame(const cv::Mat &frame) {
+        put<int32_t>(frame.rows);
+        put<int32_t>(frame.cols);
+        put<int32_t>(frame.type());
+        const size_t row = frame.cols * frame.elemSize();
+        for (int y = 0; y < frame.rows; y++)
+            putBytes(frame.ptr(y), row);
+    }
+
+    static constexpr uint32_t kMagic = 0x53434f51;  ///< "QOCS"
+    static constexpr uint32_t kVersion = 1;
+
+private:
+    std::vector<uint8_t> &blob_;
+};
+
+/**
+ * Bounds-checked reading of a blob
+ *
+ * Every read fails once one has failed, so a plugin can check a sequence of
+ * reads at the end. Nothing points into the blob afterwards.
+ */
+class QuinkOCStateReader {
+public:
+    QuinkOCStateReader(const void *data, size_t size, const char *name)
+        : data_(static_cast<const uint8_t *>(data)), size_(data ? size : 0) {
+        uint32_t magic = 0, version = 0, len = 0;
+        ok_ = get(magic) && magic == QuinkOCStateWriter::kMagic && get(version) &&
+              version == QuinkOCStateWriter::kVersion && get(len) && len == strlen(name);
+        const uint8_t *stored = ok_ ? getBytes(len) : nullptr;
+        ok_ = stored && memcmp(stored, name, len) == 0;
+    }
+
+    template <typename T>
+    bool get(T &value) {
+        static_assert(std::is_trivially_copyable<T>::value, "state values are copied bytewise");
+        const uint8_t *p = getBytes(sizeof(value));
+        if (p)
+            memcpy(&value, p, sizeof(value));
+        return p != nullptr;
+    }
+
+    /** The next size bytes, valid as long as the blob, or null past its end */
+    const uint8_t *getBytes(size_t size) {
+        if (!ok_ || size > size_ - pos_) {
+            ok_ = false;
+            return nullptr;
+        }
+        const uint8_t *p = data_ + pos_;
+        pos_ += size;
+        return p;
+    }
+
+    /** Read a frame into frame, reusing its buffer if it has the size and type */
+    bool getFrame(cv::Mat &frame) {
+        int32_t rows = 0, cols = 0, type = 0;
+        if (!get(rows) || !get(cols) || !get(type) || rows < 0 || cols < 0 ||
+            CV_MAT_TYPE(type) != type) {
+            ok_ = false;
+            return false;
+        }
+        const size_t row = static_cast<size_t>(cols) * CV_ELEM_SIZE(type);
+        if (rows > 0 && row > (size_ - pos_) / rows) {
+            ok_ = false;
+            return false;
+        }
+        frame.create(rows, cols, type);
+        for (int y = 0; y < rows; y++)
+            memcpy(frame.ptr(y), getBytes(row), row);
+        return true;
+    }
+
+    bool ok() const { return ok_; }
+
+    /** Whether everything was read, and nothing is left over */
+    bool done() const { return ok_ && pos_ == size_; }
+
+private:
+    const uint8_t *data_;
+    size_t size_;
+    size_t pos_ = 0;
+    bool ok_ = true;
+};
+
+#endif /* QUINK_OC_STATE_H */
@@ -1,4 +1,6 @@
 #include <quink_oc_plugin.h>
+#include <quink_oc_async.h>
+#include <quink_oc_state.h>
 #include <opencv2/imgproc.hpp>
 #include <cstdlib>
 #include <cstring>
@@ -29,7 +31,8 @@ public:
         if (inputs.empty() || outputs.empty())
             return QUINK_OC_ERROR;
 
-        frame_buffer_.push_back(inputs[0].clone());
+        // Retained host frames can be kept as they are
+        frame_buffer_.push_back(retained_ ? inputs[0] : inputs[0].clone());
 
         if (static_cast<int>(frame_buffer_.size()) < num_frames_)
             return QUINK_OC_TRY_AGAIN;
@@ -52,34 +55,95 @@ public:
 
     bool configure(const std::vector<QuinkOCFrameConfig> &inputs,
                    std::vector<QuinkOCFrameConfig> &outputs) override {
-        (void)inputs;
         (void)outputs;
+        if (!inputs.empty())
+            input_ = inputs[0];
+        // Retained frames are only the host's until configure() returns
+        frame_buffer_.clear();
+        output_count_ = 0;
         return true;
     }
 
     void uninit() override { frame_buffer_.clear(); }
 
+    // The window's frames go, the scratch frames stay
+    bool reset() override {
+        frame_buffer_.clear();
+        output_count_ = 0;
+        return true;
+    }
+
+    int input_lookahead() const override { return num_frames_ - 1; }
+
+    void retain_inputs(int depth) override { retained_ = depth >= num_frames_ - 1; }
+
+    // The window is the whole state; the average is recomputed from it
+    bool save_state(std::vector<uint8_t> &blob) override {
+        QuinkOCStateWriter out(blob, "avgframes");
+        out.put<int32_t>(num_frames_);
+        out.put<int32_t>(output_count_);
+        out.put<int32_t>(static_cast<int32_t>(frame_buffer_.size()));
+        for (const cv::Mat &frame : frame_buffer_)
+            out.putFrame(frame);
+        return true;
+    }
+
+    bool load_state(const void *data, size_t size) override {
+        QuinkOCStateReader in(data, size, "avgframes");
+        int32_t num_frames = 0, output_count = 0, count = 0;
+        if (!in.get(num_frames) || !in.get(output_count) || !in.get(count) ||
+            num_frames != num_frames_ || count < 0 || count >= num_frames_)
+            return false;
+
+        std::deque<cv::Mat> window(count);
+        for (cv::Mat &frame : window) {
+            if (!in.getFrame(frame) || frame.cols != input_.width || frame.rows != input_.height ||
+                frame.type() != input_.cv_type)
+                return false;
+        }
+        if (!in.done())
+            return false;
+        frame_buffer_ = std::move(window);
+        output_count_ = output_count;
+        return true;
+    }
+
+    void warmup(const std::vector<QuinkOCFrameConfig> &inputs,
+                const std::vector<QuinkOCFrameConfig> &outputs) override {
+        (void)outputs;
+        if (inputs.empty())
+            return;
+        const QuinkOCFrameConfig &in = inputs[0];
+        const int type = CV_32FC(CV_MAT_CN(in.cv_type));
+        accumulator_.create(in.height, in.width, type);
+        accumulator_.setTo(cv::Scalar::all(0));
+        temp_.create(in.height, in.width, type);
+        temp_.setTo(cv::Scalar::all(0));
+    }
+
 private:
     void computeAverage(cv::Mat &output) {
         if (frame_buffer_.empty())
             return;
         
-        cv::Mat accumulator;
-        frame_buffer_[0].convertTo(accumulator, CV_32F);
+        frame_buffer_[0].convertTo(accumulator_, CV_32F);
         
         for (size_t i = 1; i < frame_buffer_.size(); i++) {
-            cv::Mat temp;
-            frame_buffer_[i].convertTo(temp, CV_32F);
-            accumulator += temp;
+            frame_buffer_[i].convertTo(temp_, CV_32F);
+            accumulator_ += temp_;
         }
         
-        accumulator /= static_cast<double>(frame_buffer_.size());
-        accumulator.convertTo(output, frame_buffer_[0].type());
+        accumulator_ /= static_cast<double>(frame_buffer_.size());
+        accumulator_.convertTo(output, frame_buffer_[0].type());
     }
 
     int num_frames_ = 3;
+    bool retained_ = false;  ///< Host keeps the inputs alive for the whole window
+    QuinkOCFrameConfig input_ = {0, 0, 0};  ///< Configured input, for loaded frames
     std::deque<cv::Mat> frame_buffer_;
+    cv::Mat accumulator_;  ///< Scratch frames, kept between frames
+    cv::Mat temp_;
     int output_count_ = 0;
 };
 
-QUINK_OC_PLUGIN_ENTRY(FrameAveragePlugin, "avgframes", "Temporal frame averaging")
+QUINK_OC_PLUGIN_ENTRY(QuinkOCAsync<FrameAveragePlugin>, "avgframes", "Temporal frame averaging")
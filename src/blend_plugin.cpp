@@ -1,4 +1,5 @@
 #include <quink_oc_plugin.h>
+#include <quink_oc_frame_parallel.h>
 #include <opencv2/imgproc.hpp>
 #include <cstdlib>
 #include <cstring>
@@ -50,15 +51,37 @@ public:
 
     bool configure(const std::vector<QuinkOCFrameConfig> &inputs,
                    std::vector<QuinkOCFrameConfig> &outputs) override {
-        (void)inputs;
         (void)outputs;
+        // Rows only line up when the second input needs no resize
+        fusable_ = inputs.size() >= 2 && inputs[0].width == inputs[1].width &&
+                   inputs[0].height == inputs[1].height &&
+                   inputs[0].cv_type == inputs[1].cv_type;
         return true;
     }
 
     void uninit() override {}
 
+    bool reset() override { return true; }
+
+    void process_batch(const std::vector<std::vector<cv::Mat>> &inputs,
+                       std::vector<std::vector<cv::Mat>> &outputs,
+                       std::vector<QuinkOCProcessResult> &results) override {
+        process_batch_parallel(inputs, outputs, results);
+    }
+
+    int row_halo() const override { return fusable_ ? 0 : -1; }
+
+    void process_rows(const std::vector<cv::Mat> &inputs, std::vector<cv::Mat> &outputs,
+                      int y0, int y1) override {
+        cv::Mat out = outputs[0].rowRange(y0, y1);
+        cv::addWeighted(inputs[0].rowRange(y0, y1), 1.0 - alpha_, inputs[1].rowRange(y0, y1),
+                        alpha_, 0.0, out);
+    }
+
 private:
     double alpha_ = 0.5;
+    bool fusable_ = false;
 };
 
-QUINK_OC_PLUGIN_ENTRY(AlphaBlendPlugin, "blend", "Alpha blend two video streams")
+QUINK_OC_PLUGIN_ENTRY_FLAGS(QuinkOCFrameParallel<AlphaBlendPlugin>, "blend", "Alpha blend two video streams",
+                            QUINK_OC_PLUGIN_FLAG_PURE)
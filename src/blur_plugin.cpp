@@ -1,4 +1,5 @@
 #include <quink_oc_plugin.h>
+#include <quink_oc_frame_parallel.h>
 #include <opencv2/imgproc.hpp>
 #include <cstdlib>
 #include <cstring>
@@ -45,8 +46,22 @@ public:
 
     void uninit() override { }
 
+    bool reset() override { return true; }
+
+    void process_batch(const std::vector<std::vector<cv::Mat>> &inputs,
+                       std::vector<std::vector<cv::Mat>> &outputs,
+                       std::vector<QuinkOCProcessResult> &results) override {
+        process_batch_parallel(inputs, outputs, results);
+    }
+
+    void warmup(const std::vector<QuinkOCFrameConfig> &inputs,
+                const std::vector<QuinkOCFrameConfig> &outputs) override {
+        warmup_process(inputs, outputs);
+    }
+
 private:
     int kernel_size_ = 5;
 };
 
-QUINK_OC_PLUGIN_ENTRY(GaussianBlurPlugin, "blur", "Gaussian blur effect")
+QUINK_OC_PLUGIN_ENTRY_FLAGS(QuinkOCFrameParallel<GaussianBlurPlugin>, "blur", "Gaussian blur effect",
+                            QUINK_OC_PLUGIN_FLAG_PURE)
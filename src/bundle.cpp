@@ -0,0 +1,33 @@
+#include <quink_oc_plugin.h>
+
+/**
+ * Registry of the bundle library
+ *
+ * Every plugin compiled with QUINK_OC_PLUGIN_BUNDLE registers its descriptor
+ * from a static initializer; the order across files is unspecified, hosts
+ * select by name. Plugins share one OpenCV and one copy of the kernels, so a
+ * single dlopen serves a whole filter chain.
+ */
+namespace {
+
+std::vector<const QuinkOCPluginDescriptor *> &registry() {
+    static std::vector<const QuinkOCPluginDescriptor *> descs;
+    return descs;
+}
+
+} // namespace
+
+void quink_oc_bundle_register(const QuinkOCPluginDescriptor *desc) {
+    registry().push_back(desc);
+}
+
+extern "C" QUINK_OC_EXPORT const QuinkOCPluginDescriptor *quink_oc_plugin_enum_descriptors(int index) {
+    const std::vector<const QuinkOCPluginDescriptor *> &descs = registry();
+    if (index < 0 || static_cast<size_t>(index) >= descs.size())
+        return nullptr;
+    return descs[index];
+}
+
+extern "C" QUINK_OC_EXPORT int quink_oc_plugin_get_api_level() {
+    return QUINK_OC_PLUGIN_API_LEVEL;
+}
@@ -0,0 +1,25 @@
+#include "chain_kernels.h"
+#include <cstring>
+
+namespace QUINK_OC_ISA_NS {
+namespace {
+
+const int kHashLanes = 32;
+
+} // namespace
+
+void chainHashBlocks(uint32_t *acc, const unsigned char *data, size_t blocks) {
+    uint32_t lanes[kHashLanes];
+    memcpy(lanes, acc, sizeof(lanes));
+    for (size_t b = 0; b < blocks; b++, data += sizeof(lanes)) {
+        for (int i = 0; i < kHashLanes; i++) {
+            uint32_t v;
+            memcpy(&v, data + i * sizeof(v), sizeof(v));
+            const uint32_t a = lanes[i] + v * 2246822519u;
+            lanes[i] = ((a << 13) | (a >> 19)) * 2654435761u;
+        }
+    }
+    memcpy(acc, lanes, sizeof(lanes));
+}
+
+} // namespace QUINK_OC_ISA_NS
@@ -0,0 +1,15 @@
+#ifndef QUINK_OC_CHAIN_KERNELS_H
+#define QUINK_OC_CHAIN_KERNELS_H
+
+#include "quink_oc_cpu.h"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Hash rounds of quink_oc_hash_blocks() (quink_oc_memo.h) for the memo
+ * cache: 32 lanes, 128 bytes per block.
+ */
+QUINK_OC_DECLARE_KERNEL(void, chainHashBlocks,
+                        (uint32_t *acc, const unsigned char *data, size_t blocks))
+
+#endif /* QUINK_OC_CHAIN_KERNELS_H */
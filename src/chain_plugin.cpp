@@ -0,0 +1,765 @@
+#include <quink_oc_plugin.h>
+#include <quink_oc_memo.h>
+#include <quink_oc_proxy.h>
+#include <quink_oc_pipeline.h>
+#include <quink_oc_state.h>
+#include "chain_kernels.h"
+#include "quink_oc_loader.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+
+/**
+ * In-process chain of plugins.
+ *
+ * params is a '|' separated list of stages, each
+ *
+ *     library[#name][@IxO][?params]
+ *
+ * e.g. "libblur_plugin.so?ksize=5|libscale_plugin.so?w=1280:filter=area".
+ * #name selects a plugin from a bundle library. @IxO sets the stage's number
+ * of inputs and outputs: inputs default to the previous stage's outputs (1
+ * for the first stage), outputs to 1 (the chain's outputs for the last
+ * stage). Inputs beyond what the previous stage produces are taken from the
+ * chain inputs not consumed yet, so "blur, then blend with the second input"
+ * is "libblur_plugin.so|libblend_plugin.so@2x1" with inputs=2. Extra inputs
+ * are the current frames, not delayed by earlier stages' lookahead.
+ *
+ * Frames are handed between stages as cv::Mat in buffers allocated once in
+ * configure(). A TRY_AGAIN from any stage ends the call; at end of stream
+ * each stage is flushed in order and its frames pushed through the stages
+ * after it.
+ *
+ * A leading "pipeline=1[:queue=N]|" runs every stage on its own thread
+ * instead (see quink_oc_pipeline.h), with N frames in flight per link
+ * (default 2). Throughput is then bound by the slowest stage rather than
+ * the sum, at the cost of copying frames in and out and of a few frames
+ * of latency. It needs all chain inputs to go to the first stage and falls
+ * back to running the stages in turn otherwise.
+ *
+ * Without the pipeline, consecutive stages whose plugins have a row form
+ * (row_halo() >= 0, API level 2) are fused: they run tile by tile over a
+ * few rows at a time, so what one stage writes is still in cache when the
+ * next one reads it, and tiles run in parallel when no stage needs
+ * neighbouring rows. "fuse=0|" turns this off.
+ *
+ * "memo=N|" keeps the outputs of the last N distinct input frame sets of
+ * every stage whose plugin is marked QUINK_OC_PLUGIN_FLAG_PURE and reuses
+ * them when the same input comes again (see quink_oc_memo.h), which pays off
+ * on looped content. Memoized stages are not fused; the pipeline doesn't
+ * memoize.
+ *
+ * The chain's inputs go straight to the first stage, so the chain asks the
+ * host to retain them for the first stage's input_lookahead() (API level 4),
+ * plus the queue depth with the pipeline, whose first link then holds
+ * the host frames instead of copies.
+ *
+ * Frames go from stage to stage without copies, so all frames the chain
+ * allocates have the row alignment and padding of every stage's
+ * frame_layout() (API level 5), and the chain asks the host for the same.
+ *
+ * Metadata of every stage (API level 7) follows the frames it describes
+ * through the stages after it and is reported with the chain's outputs;
+ * memoized stages report what was stored with the outputs, fused runs only
+ * pass on what came in.
+ *
+ * Stages asking for luma proxies (API level 8) get them from pyramids the
+ * chain builds per frame, shared by all stages that see the same frame.
+ *
+ * The chain can be reset if all its stages can (API level 11), and its
+ * state saved and loaded as the stages' blobs in a blob of its own (API
+ * level 12); the pipeline only loads, its frames in flight aren't saved.
+ */
+class ChainPlugin : public QuinkOCPlugin {
+public:
+    ~ChainPlugin() override { release(); }
+
+    bool init(const char *params, int nb_inputs, int nb_outputs) override {
+        if (nb_inputs < 1 || nb_outputs < 1 || !params || !params[0])
+            return false;
+        nb_inputs_ = nb_inputs;
+
+        std::string spec(params);
+        size_t start = 0;
+        size_t first_end = spec.find('|');
+        if (first_end != std::string::npos && isOptions(spec.substr(0, first_end))) {
+            parseOptions(spec.substr(0, first_end));
+            start = first_end + 1;
+        }
+        while (start <= spec.size()) {
+            size_t end = spec.find('|', start);
+            if (end == std::string::npos)
+                end = spec.size();
+            if (!addStage(spec.substr(start, end - start)))
+                return false;
+            start = end + 1;
+        }
+
+        // Wire up the inputs, now that the last stage is known
+        int prev_outputs = 0;
+        int next_extra = 0;
+        for (size_t i = 0; i < stages_.size(); i++) {
+            Stage &s = stages_[i];
+            const bool last = i + 1 == stages_.size();
+            if (s.nb_inputs == 0)
+                s.nb_inputs = i == 0 ? (last ? nb_inputs : 1) : prev_outputs;
+            if (s.nb_outputs == 0)
+                s.nb_outputs = last ? nb_outputs : 1;
+            if (last && s.nb_outputs != nb_outputs)
+                return false;
+            if (s.nb_inputs < prev_outputs)
+                return false;  // Outputs of the previous stage would be dropped
+
+            s.first_extra = next_extra;
+            next_extra += s.nb_inputs - prev_outputs;
+            if (next_extra > nb_inputs)
+                return false;
+            if (!s.plugin->init(s.params.empty() ? nullptr : s.params.c_str(),
+                                s.nb_inputs, s.nb_outputs))
+                return false;
+            s.initialized = true;
+            prev_outputs = s.nb_outputs;
+        }
+        return next_extra == nb_inputs;
+    }
+
+    QuinkOCProcessResult process(const std::vector<cv::Mat> &inputs,
+                                 std::vector<cv::Mat> &outputs) override {
+        if (inputs.size() < static_cast<size_t>(nb_inputs_) || stages_.empty())
+            return QUINK_OC_ERROR;
+        if (pipelined_)
+            return pipeline_.process(inputs, outputs);
+
+        chain_inputs_ = &inputs;
+        QuinkOCProcessResult ret = runFrom(0, nullptr, outputs, {});
+        chain_inputs_ = nullptr;
+
+        // Inputs are only valid during this call, keep what flush() may need
+        for (size_t k = flushExtrasFrom(); k < extra_copies_.size(); k++)
+            inputs[k].copyTo(extra_copies_[k]);
+        return ret;
+    }
+
+    bool flush(std::vector<cv::Mat> &outputs) override {
+        if (pipelined_)
+            return pipeline_.flush(outputs);
+        while (flush_stage_ < stages_.size()) {
+            Stage &s = stages_[flush_stage_];
+            const bool last = flush_stage_ + 1 == stages_.size();
+            if (last)
+                host_outputs_ = outputs;
+            else
+                resetOutputs(s);
+            if (!s.plugin->flush(last ? outputs : s.outputs)) {
+                flush_stage_++;
+                continue;
+            }
+            std::vector<QuinkOCMetadataEntry> metadata = s.metadata.pop(s.nb_outputs);
+            if (s.api_level >= 7)
+                s.plugin->output_metadata(metadata);
+            if (last) {
+                metadata_ = std::move(metadata);
+                return finishOutputs(outputs);
+            }
+
+            // There are no chain inputs at end of stream; stages taking
+            // extra inputs get copies of the last ones seen.
+            chain_inputs_ = &extra_copies_;
+            QuinkOCProcessResult ret = runFrom(flush_stage_ + 1, &s.outputs, outputs, std::move(metadata));
+            chain_inputs_ = nullptr;
+            if (ret == QUINK_OC_OK)
+                return true;
+            if (ret == QUINK_OC_ERROR)
+                return false;
+        }
+        return false;
+    }
+
+    bool configure(const std::vector<QuinkOCFrameConfig> &inputs,
+                   std::vector<QuinkOCFrameConfig> &outputs) override {
+        if (inputs.size() < static_cast<size_t>(nb_inputs_) || stages_.empty())
+            return false;
+
+        pipeline_.stop();
+        pipelined_ = pipelines();
+
+        std::vector<QuinkOCFrameConfig> prev;
+        for (size_t i = 0; i < stages_.size(); i++) {
+            Stage &s = stages_[i];
+            std::vector<QuinkOCFrameConfig> in(prev);
+            for (int k = 0; in.size() < static_cast<size_t>(s.nb_inputs); k++)
+                in.push_back(inputs[s.first_extra + k]);
+
+            // Same defaults as the host: output[i] = input[i], or input[0]
+            std::vector<QuinkOCFrameConfig> out;
+            for (int k = 0; k < s.nb_outputs; k++)
+                out.push_back(in[k < s.nb_inputs ? k : 0]);
+            if (!s.plugin->configure(in, out))
+                return false;
+
+            // Outputs keep the pixel format of the input they default to
+            for (int k = 0; k < s.nb_outputs; k++)
+                out[k].cv_type = in[k < s.nb_inputs ? k : 0].cv_type;
+
+            s.inputs = in;
+            s.configs = out;
+            s.layout = {1, 0};
+            if (s.api_level >= 5)
+                s.layout = s.plugin->frame_layout();
+            s.proxy_scale = 0;
+            if (s.api_level >= 8)
+                s.proxy_scale = s.plugin->proxy_scale();
+            s.holds_frames = s.api_level >= 4 && s.plugin->input_lookahead() > 0;
+            s.halo = -1;
+            if (fuse_ && !pipelined_ && s.api_level >= 2 && s.proxy_scale <= 0 && sameHeight(in, out))
+                s.halo = s.plugin->row_halo();
+            prev = out;
+        }
+
+        // Frames move between stages without copies (pass-through, memoized
+        // outputs), so every frame gets the layout all stages need together
+        layout_ = {1, 0};
+        for (const Stage &s : stages_)
+            layout_ = quink_oc_merge_layout(layout_, s.layout);
+
+        for (size_t i = 0; i < stages_.size(); i++) {
+            Stage &s = stages_[i];
+            s.fuse_end = 0;
+            s.metadata.clear();
+            s.memo.reset();
+            if (memo_size_ > 0 && !pipelined_ && s.api_level >= 3 &&
+                (s.desc->flags & QUINK_OC_PLUGIN_FLAG_PURE)) {
+                s.memo.reset(new QuinkOCMemoCache(memo_size_, s.params.c_str(), hash_blocks_, layout_));
+                s.halo = -1;
+            }
+            s.buffers.clear();
+            s.outputs.clear();
+            if (i + 1 < stages_.size() && !pipelined_) {
+                for (const QuinkOCFrameConfig &cfg : s.configs)
+                    s.buffers.push_back(quink_oc_alloc_frame(cfg.height, cfg.width, cfg.cv_type, layout_));
+                s.outputs.resize(s.buffers.size());
+            }
+        }
+
+        // Runs of at least two fusable stages over frames of the same height
+        for (size_t i = 0; i < stages_.size();) {
+            size_t end = i + 1;
+            while (stages_[i].halo >= 0 && end < stages_.size() && stages_[end].halo >= 0 &&
+                   stages_[end].configs[0].height == stages_[i].configs[0].height)
+                end++;
+            if (end - i >= 2)
+                stages_[i].fuse_end = end;
+            i = end;
+        }
+
+        for (size_t k = 0; k < outputs.size() && k < prev.size(); k++) {
+            outputs[k].width = prev[k].width;
+            outputs[k].height = prev[k].height;
+        }
+
+        if (pipelined_) {
+            std::vector<QuinkOCPipelineStage> pipeline_stages;
+            for (const Stage &s : stages_)
+                pipeline_stages.push_back({s.plugin, s.configs, s.layout, s.api_level >= 7,
+                                           s.proxy_scale});
+            pipeline_.start(pipeline_stages,
+                            std::vector<QuinkOCFrameConfig>(inputs.begin(), inputs.begin() + nb_inputs_),
+                            queue_depth_, borrow_);
+            return true;
+        }
+
+        // Only inputs consumed after the first stage are needed when flushing
+        extra_copies_.assign(nb_inputs_, cv::Mat());
+        if (stages_.size() > 1 && stages_[0].nb_inputs < nb_inputs_) {
+            for (int k = stages_[0].nb_inputs; k < nb_inputs_; k++)
+                extra_copies_[k] = quink_oc_alloc_frame(inputs[k].height, inputs[k].width,
+                                                        inputs[k].cv_type, layout_);
+        } else {
+            extra_copies_.clear();
+        }
+        flush_stage_ = 0;
+        metadata_.clear();
+        return true;
+    }
+
+    void uninit() override { release(); }
+
+    void warmup(const std::vector<QuinkOCFrameConfig> &inputs,
+                const std::vector<QuinkOCFrameConfig> &outputs) override {
+        (void)inputs;
+        (void)outputs;
+        for (Stage &s : stages_) {
+            if (s.api_level >= 10)
+                s.plugin->warmup(s.inputs, s.configs);
+            for (cv::Mat &frame : s.buffers)
+                frame.setTo(cv::Scalar::all(0));
+        }
+        for (cv::Mat &frame : extra_copies_)
+            frame.setTo(cv::Scalar::all(0));
+        if (pipelined_)
+            pipeline_.warmup();
+    }
+
+    // Memoized outputs only depend on the inputs and stay valid
+    bool reset() override {
+        for (const Stage &s : stages_) {
+            if (s.api_level < 11)
+                return false;
+        }
+        if (pipelined_)
+            return pipeline_.reset();
+        for (Stage &s : stages_) {
+            if (!s.plugin->reset())
+                return false;
+            s.metadata.clear();
+        }
+        flush_stage_ = 0;
+        metadata_.clear();
+        return true;
+    }
+
+    bool save_state(std::vector<uint8_t> &blob) override {
+        if (pipelined_ || flush_stage_ > 0 || !stateful())
+            return false;
+        std::vector<uint8_t> stage_blob;
+        QuinkOCStateWriter out(blob, "chain");
+        out.put<uint32_t>(static_cast<uint32_t>(stages_.size()));
+        for (Stage &s : stages_) {
+            stage_blob.clear();
+            if (!s.plugin->save_state(stage_blob))
+                return false;
+            out.put<uint64_t>(stage_blob.size());
+            out.putBytes(stage_blob.data(), stage_blob.size());
+        }
+        return true;
+    }
+
+    bool load_state(const void *data, size_t size) override {
+        if (!stateful())
+            return false;
+        QuinkOCStateReader in(data, size, "chain");
+        uint32_t count = 0;
+        bool ok = in.get(count) && count == stages_.size();
+        size_t loaded = 0;
+        for (; ok && loaded < stages_.size(); loaded++) {
+            uint64_t stage_size = 0;
+            const uint8_t *stage_data = in.get(stage_size) ? in.getBytes(stage_size) : nullptr;
+            ok = stage_data && stages_[loaded].plugin->load_state(stage_data, stage_size);
+        }
+        if (ok && in.done())
+            return true;
+        // Stages already loaded go back to the start of a stream
+        for (size_t i = 0; i < loaded; i++)
+            stages_[i].plugin->reset();
+        return false;
+    }
+
+    void output_metadata(std::vector<QuinkOCMetadataEntry> &entries) override {
+        if (pipelined_) {
+            pipeline_.output_metadata(entries);
+            return;
+        }
+        entries.insert(entries.end(), metadata_.begin(), metadata_.end());
+        metadata_.clear();
+    }
+
+    int input_lookahead() const override {
+        if (stages_.empty())
+            return 0;
+        const Stage &s = stages_[0];
+        const int lookahead = s.api_level >= 4 ? s.plugin->input_lookahead() : 0;
+        return pipelines() ? queue_depth_ + lookahead : lookahead;
+    }
+
+    QuinkOCFrameLayout frame_layout() const override { return layout_; }
+
+    void retain_inputs(int depth) override {
+        if (stages_.empty())
+            return;
+        borrow_ = pipelines() && depth >= input_lookahead();
+        if (pipelines())
+            depth = borrow_ ? depth - queue_depth_ : 0;
+        if (stages_[0].api_level >= 4)
+            stages_[0].plugin->retain_inputs(depth);
+    }
+
+private:
+    struct Stage {
+        void *library = nullptr;
+        const QuinkOCPluginDescriptor *desc = nullptr;
+        int api_level = 1;   ///< Of the stage's library, at most the chain's
+        QuinkOCPlugin *plugin = nullptr;
+        std::string params;
+        int nb_inputs = 0;   ///< 0 until init() resolves the default
+        int nb_outputs = 0;
+        int first_extra = 0; ///< First chain input taken beyond the previous stage's outputs
+        bool initialized = false;
+        bool holds_frames = false;  ///< Has lookahead or returned TRY_AGAIN, may emit in flush()
+        std::vector<QuinkOCFrameConfig> inputs;   ///< Configured inputs
+        std::vector<QuinkOCFrameConfig> configs;  ///< Configured outputs
+        QuinkOCFrameLayout layout = {1, 0};  ///< frame_layout() after configure
+        int halo = -1;        ///< row_halo() after configure, -1 if not fusable
+        int proxy_scale = 0;  ///< proxy_scale() after configure
+        size_t fuse_end = 0;  ///< On the first stage of a fused run, the stage after it
+        std::unique_ptr<QuinkOCMemoCache> memo;  ///< Outputs by input, pure plugins only
+        QuinkOCMetadataCarrier metadata;  ///< Of the frames taken in and not output yet
+        std::vector<cv::Mat> buffers;  ///< Intermediate frames, empty for the last stage
+        std::vector<cv::Mat> outputs;  ///< What the stage wrote: buffers or pass-through
+    };
+
+    /**
+     * First chain input flush() may still need. Only stages after one that
+     * holds frames back take extra inputs at end of stream; until a stage
+     * does, nothing has to be copied.
+     */
+    size_t flushExtrasFrom() const {
+        for (size_t i = 0; i + 1 < stages_.size(); i++) {
+            if (stages_[i].holds_frames)
+                return stages_[i + 1].first_extra;
+        }
+        return extra_copies_.size();
+    }
+
+    /** Whether all stages have save_state() and load_state() */
+    bool stateful() const {
+        for (const Stage &s : stages_) {
+            if (s.api_level < 12)
+                return false;
+        }
+        return !stages_.empty();
+    }
+
+    /** Whether configure() starts the pipeline, known once init() has wired the stages */
+    bool pipelines() const { return queue_depth_ > 0 && stages_[0].nb_inputs == nb_inputs_; }
+
+    /** A segment of key=value pairs rather than a library */
+    static bool isOptions(const std::string &segment) {
+        size_t eq = segment.find('=');
+        return eq != std::string::npos && segment.find('?') == std::string::npos &&
+               segment.find_first_of("./\\#@") > eq;
+    }
+
+    void parseOptions(const std::string &options) {
+        const char *str = options.c_str();
+        const char *pos = strstr(str, "fuse=");
+        if (pos)
+            fuse_ = atoi(pos + 5) != 0;
+
+        pos = strstr(str, "memo=");
+        if (pos) {
+            memo_size_ = atoi(pos + 5);
+            if (memo_size_ < 0)
+                memo_size_ = 0;
+            if (memo_size_ > 64)
+                memo_size_ = 64;
+        }
+
+        pos = strstr(str, "pipeline=");
+        if (pos && atoi(pos + 9) > 0)
+            queue_depth_ = 2;
+
+        pos = strstr(str, "queue=");
+        if (pos && queue_depth_ > 0) {
+            queue_depth_ = atoi(pos + 6);
+            if (queue_depth_ < 1)
+                queue_depth_ = 1;
+            if (queue_depth_ > 16)
+                queue_depth_ = 16;
+        }
+    }
+
+    bool addStage(const std::string &spec) {
+        Stage s;
+        size_t q = spec.find('?');
+        std::string lib = spec.substr(0, q);
+        if (q != std::string::npos)
+            s.params = spec.substr(q + 1);
+
+        size_t at = lib.rfind('@');
+        if (at != std::string::npos) {
+            int in = 0, out = 0;
+            char tail = 0;
+            if (sscanf(lib.c_str() + at + 1, "%dx%d%c", &in, &out, &tail) == 2 &&
+                in > 0 && out > 0) {
+                s.nb_inputs = in;
+                s.nb_outputs = out;
+                lib.resize(at);
+            }
+        }
+
+        std::string name;
+        size_t hash = lib.rfind('#');
+        if (hash != std::string::npos) {
+            name = lib.substr(hash + 1);
+            lib.resize(hash);
+        }
+        if (lib.empty())
+            return false;
+
+        s.library = quink_oc_library_open(lib.c_str());
+        if (!s.library)
+            return false;
+        s.desc = quink_oc_library_descriptor(s.library, name.empty() ? nullptr : name.c_str(), &s.api_level);
+        if (s.desc)
+            s.plugin = s.desc->create();
+        stages_.push_back(std::move(s));
+        return stages_.back().plugin != nullptr;
+    }
+
+    static bool sameHeight(const std::vector<QuinkOCFrameConfig> &in,
+                           const std::vector<QuinkOCFrameConfig> &out) {
+        for (const QuinkOCFrameConfig &cfg : in) {
+            if (cfg.height != in[0].height)
+                return false;
+        }
+        for (const QuinkOCFrameConfig &cfg : out) {
+            if (cfg.height != in[0].height)
+                return false;
+        }
+        return true;
+    }
+
+    /** Host buffers a fused last stage can write rows into directly */
+    static bool matchesConfig(const std::vector<cv::Mat> &frames,
+                              const std::vector<QuinkOCFrameConfig> &configs) {
+        if (frames.size() < configs.size())
+            return false;
+        for (size_t k = 0; k < configs.size(); k++) {
+            if (frames[k].cols != configs[k].width || frames[k].rows != configs[k].height ||
+                frames[k].type() != configs[k].cv_type)
+                return false;
+        }
+        return true;
+    }
+
+    void resetOutputs(Stage &s) {
+        for (size_t k = 0; k < s.buffers.size(); k++)
+            s.outputs[k] = s.buffers[k];
+    }
+
+    /**
+     * Run stages [first, end) on the previous stage's outputs, or on the
+     * chain inputs when first is 0, with the last stage writing to outputs.
+     * metadata belongs to prev; what reaches the outputs is kept for
+     * output_metadata().
+     */
+    QuinkOCProcessResult runFrom(size_t first, const std::vector<cv::Mat> *prev,
+                                 std::vector<cv::Mat> &outputs,
+                                 std::vector<QuinkOCMetadataEntry> metadata) {
+        std::vector<cv::Mat> in;
+        pyramids_used_ = 0;
+        for (size_t i = first; i < stages_.size(); i++) {
+            Stage &s = stages_[i];
+            if (s.fuse_end > i + 1 &&
+                (s.fuse_end < stages_.size() || matchesConfig(outputs, stages_.back().configs))) {
+                runFused(i, prev, outputs);
+                // Row kernels report no metadata, the frames' own goes on
+                for (size_t k = i; k < s.fuse_end; k++) {
+                    stages_[k].metadata.push(std::move(metadata));
+                    metadata = stages_[k].metadata.pop(stages_[k].nb_outputs);
+                }
+                if (s.fuse_end == stages_.size()) {
+                    metadata_ = std::move(metadata);
+                    return QUINK_OC_OK;
+                }
+                i = s.fuse_end - 1;
+                prev = &stages_[i].outputs;
+                continue;
+            }
+
+            in.clear();
+            if (prev)
+                in.assign(prev->begin(), prev->end());
+            for (int k = 0; in.size() < static_cast<size_t>(s.nb_inputs); k++)
+                in.push_back((*chain_inputs_)[s.first_extra + k]);
+            if (s.proxy_scale > 0) {
+                for (int k = 0; k < s.nb_inputs; k++)
+                    in.push_back(pyramidOf(in[k]).level(s.proxy_scale));
+            }
+
+            const bool last = i + 1 == stages_.size();
+            if (last)
+                host_outputs_ = outputs;
+            else
+                resetOutputs(s);
+            std::vector<cv::Mat> &out = last ? outputs : s.outputs;
+            std::vector<QuinkOCMetadataEntry> own;
+            s.metadata.push(std::move(metadata));
+            QuinkOCProcessResult ret = QUINK_OC_OK;
+            if (!s.memo || !s.memo->lookup(in, out, &own)) {
+                ret = s.plugin->process(in, out);
+                if (ret == QUINK_OC_OK && s.api_level >= 7)
+                    s.plugin->output_metadata(own);
+                if (ret == QUINK_OC_OK && s.memo)
+                    s.memo->store(out, &own);
+                else if (ret == QUINK_OC_TRY_AGAIN)
+                    s.memo.reset();  // Delays frames (e.g. frame_threads), outputs aren't for in
+            }
+            if (ret == QUINK_OC_TRY_AGAIN)
+                s.holds_frames = true;
+            if (ret != QUINK_OC_OK)
+                return ret;
+            metadata = s.metadata.pop(s.nb_outputs);
+            metadata.insert(metadata.end(), own.begin(), own.end());
+            if (last) {
+                metadata_ = std::move(metadata);
+                return finishOutputs(outputs) ? QUINK_OC_OK : QUINK_OC_ERROR;
+            }
+            prev = &s.outputs;
+        }
+        return QUINK_OC_ERROR;
+    }
+
+    /** The pyramid of frame, shared by the stages of one runFrom() */
+    QuinkOCProxyPyramid &pyramidOf(const cv::Mat &frame) {
+        for (size_t i = 0; i < pyramids_used_; i++) {
+            if (pyramids_[i].holds(frame))
+                return pyramids_[i];
+        }
+        if (pyramids_used_ == pyramids_.size())
+            pyramids_.emplace_back();
+        QuinkOCProxyPyramid &pyramid = pyramids_[pyramids_used_++];
+        pyramid.set(frame);
+        return pyramid;
+    }
+
+    /**
+     * Run the fused stages [first, stages_[first].fuse_end) row tile by row tile
+     *
+     * Tiles are sized so a tile of every frame involved fits in L2. When
+     * every halo is 0 each tile is independent and tiles run in parallel;
+     * otherwise stages advance in a wavefront, each as far as the rows its
+     * predecessor has finished allow.
+     */
+    void runFused(size_t first, const std::vector<cv::Mat> *prev, std::vector<cv::Mat> &outputs) {
+        const size_t end = stages_[first].fuse_end;
+        const size_t count = end - first;
+        std::vector<std::vector<cv::Mat>> ins(count);
+        std::vector<std::vector<cv::Mat> *> outs(count);
+        size_t row_bytes = 0;
+        int max_halo = 0;
+        for (size_t i = first; i < end; i++) {
+            Stage &s = stages_[i];
+            std::vector<cv::Mat> &in = ins[i - first];
+            if (prev)
+                in.assign(prev->begin(), prev->end());
+            for (int k = 0; in.size() < static_cast<size_t>(s.nb_inputs); k++)
+                in.push_back((*chain_inputs_)[s.first_extra + k]);
+            if (i == first) {
+                for (const cv::Mat &frame : in)
+                    row_bytes += frame.cols * frame.elemSize();
+            }
+
+            if (i + 1 < stages_.size()) {
+                resetOutputs(s);
+                outs[i - first] = &s.outputs;
+            } else {
+                outs[i - first] = &outputs;
+            }
+            for (const QuinkOCFrameConfig &cfg : s.configs)
+                row_bytes += static_cast<size_t>(cfg.width) * CV_ELEM_SIZE(cfg.cv_type);
+            if (s.halo > max_halo)
+                max_halo = s.halo;
+            prev = &s.outputs;
+        }
+
+        const int height = stages_[first].configs[0].height;
+        int tile = static_cast<int>(kFusionTileBytes / (row_bytes ? row_bytes : 1));
+        if (tile < 4)
+            tile = 4;
+
+        if (max_halo == 0) {
+            const int nb_tiles = (height + tile - 1) / tile;
+            cv::parallel_for_(cv::Range(0, nb_tiles), [&](const cv::Range &range) {
+                for (int t = range.start; t < range.end; t++) {
+                    const int y0 = t * tile;
+                    const int y1 = height - y0 < tile ? height : y0 + tile;
+                    for (size_t k = 0; k < count; k++)
+                        stages_[first + k].plugin->process_rows(ins[k], *outs[k], y0, y1);
+                }
+            });
+            return;
+        }
+
+        std::vector<int> done(count, 0);
+        while (done[count - 1] < height) {
+            for (size_t k = 0; k < count; k++) {
+                int limit = height;
+                if (k > 0 && done[k - 1] < height)
+                    limit = done[k - 1] - stages_[first + k].halo;
+                const int y1 = limit - done[k] < tile ? limit : done[k] + tile;
+                if (y1 <= done[k])
+                    continue;
+                stages_[first + k].plugin->process_rows(ins[k], *outs[k], done[k], y1);
+                done[k] = y1;
+            }
+        }
+    }
+
+    /**
+     * The last stage may pass through a frame the host doesn't know, from an
+     * intermediate buffer or a retained copy; write those into the host's
+     * buffers. Pass-through of a current chain input is left to the host.
+     */
+    bool finishOutputs(std::vector<cv::Mat> &outputs) {
+        for (size_t k = 0; k < outputs.size() && k < host_outputs_.size(); k++) {
+            cv::Mat &out = outputs[k];
+            if (out.data == host_outputs_[k].data || isHostInput(out))
+                continue;
+            if (out.size() != host_outputs_[k].size() || out.type() != host_outputs_[k].type())
+                return false;
+            out.copyTo(host_outputs_[k]);
+            out = host_outputs_[k];
+        }
+        host_outputs_.clear();
+        return true;
+    }
+
+    bool isHostInput(const cv::Mat &frame) const {
+        if (!chain_inputs_ || chain_inputs_ == &extra_copies_)
+            return false;
+        for (const cv::Mat &in : *chain_inputs_) {
+            if (frame.data >= in.datastart && frame.data < in.dataend)
+                return true;
+        }
+        return false;
+    }
+
+    void release() {
+        pipeline_.stop();
+        pipelined_ = false;
+        for (Stage &s : stages_) {
+            if (s.plugin) {
+                if (s.initialized)
+                    s.plugin->uninit();
+                s.desc->destroy(s.plugin);
+            }
+            quink_oc_library_close(s.library);
+        }
+        stages_.clear();
+    }
+
+    static constexpr size_t kFusionTileBytes = 256 * 1024;
+
+    int nb_inputs_ = 0;
+    bool fuse_ = true;
+    int memo_size_ = 0;  ///< Frame sets memoized per pure stage, 0 for none
+    decltype(&isa_baseline::chainHashBlocks) hash_blocks_ = QUINK_OC_DISPATCH(chainHashBlocks);
+    int queue_depth_ = 0;  ///< Frames in flight per pipeline link, 0 for no pipeline
+    bool pipelined_ = false;
+    bool borrow_ = false;  ///< Host retains its frames for the pipeline's first link
+    QuinkOCFrameLayout layout_ = {1, 0};  ///< What all stages need, for all frames
+    QuinkOCPipeline pipeline_;
+    std::vector<Stage> stages_;
+    size_t flush_stage_ = 0;
+    const std::vector<cv::Mat> *chain_inputs_ = nullptr;  ///< Set during a call
+    std::vector<cv::Mat> extra_copies_;   ///< Chain inputs later stages need when flushing
+    std::vector<cv::Mat> host_outputs_;   ///< Host buffers while the last stage runs
+    std::vector<QuinkOCMetadataEntry> metadata_;  ///< Of the frame set last returned
+    std::vector<QuinkOCProxyPyramid> pyramids_;   ///< Of the frames seen in a runFrom()
+    size_t pyramids_used_ = 0;
+};
+
+QUINK_OC_PLUGIN_ENTRY(ChainPlugin, "chain", "Run several plugins in-process as one")
@@ -0,0 +1,49 @@
+#include "clahe_kernels.h"
+
+namespace QUINK_OC_ISA_NS {
+namespace {
+
+/**
+ * Like cv::saturate_cast<uchar>: clamp, then round half to even. Adding and
+ * subtracting 2^23 leaves no fraction bits, so the FPU rounds to nearest even
+ * inline; std::nearbyint would be a libm call at the baseline level.
+ */
+inline uint8_t saturateU8(float v) {
+    v = v < 0.0f ? 0.0f : (v > 255.0f ? 255.0f : v);
+    return static_cast<uint8_t>((v + 0x1.0p23f) - 0x1.0p23f);
+}
+
+} // namespace
+
+void claheBlendRow(const float *tl, const float *tr, const float *bl, const float *br,
+                   const float *wx, float wy, const uint8_t *luma, float *delta, int n) {
+    for (int x = 0; x < n; x++) {
+        float top = tl[x] + (tr[x] - tl[x]) * wx[x];
+        float bot = bl[x] + (br[x] - bl[x]) * wx[x];
+        delta[x] = top + (bot - top) * wy - luma[x];
+    }
+}
+
+void claheApplyRow(const uint8_t *src, uint8_t *dst, const float *delta, int n, int cn) {
+    if (cn == 1) {
+        for (int x = 0; x < n; x++)
+            dst[x] = saturateU8(src[x] + delta[x]);
+        return;
+    }
+    if (cn == 3) {
+        for (int x = 0; x < n; x++) {
+            dst[x * 3 + 0] = saturateU8(src[x * 3 + 0] + delta[x]);
+            dst[x * 3 + 1] = saturateU8(src[x * 3 + 1] + delta[x]);
+            dst[x * 3 + 2] = saturateU8(src[x * 3 + 2] + delta[x]);
+        }
+        return;
+    }
+    for (int x = 0; x < n; x++) {
+        dst[x * 4 + 0] = saturateU8(src[x * 4 + 0] + delta[x]);
+        dst[x * 4 + 1] = saturateU8(src[x * 4 + 1] + delta[x]);
+        dst[x * 4 + 2] = saturateU8(src[x * 4 + 2] + delta[x]);
+        dst[x * 4 + 3] = src[x * 4 + 3];
+    }
+}
+
+} // namespace QUINK_OC_ISA_NS
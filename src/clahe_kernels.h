@@ -0,0 +1,19 @@
+#ifndef QUINK_OC_CLAHE_KERNELS_H
+#define QUINK_OC_CLAHE_KERNELS_H
+
+#include "quink_oc_cpu.h"
+#include <cstdint>
+
+/**
+ * Bilinear blend of the four gathered tile mappings of one row into a luma
+ * delta: delta[x] = lerp(lerp(tl, tr, wx), lerp(bl, br, wx), wy) - luma[x].
+ */
+QUINK_OC_DECLARE_KERNEL(void, claheBlendRow,
+                        (const float *tl, const float *tr, const float *bl, const float *br,
+                         const float *wx, float wy, const uint8_t *luma, float *delta, int n))
+
+/** Add the luma delta to the first min(cn, 3) channels, alpha passes through. */
+QUINK_OC_DECLARE_KERNEL(void, claheApplyRow,
+                        (const uint8_t *src, uint8_t *dst, const float *delta, int n, int cn))
+
+#endif /* QUINK_OC_CLAHE_KERNELS_H */
@@ -0,0 +1,252 @@
+#include <quink_oc_plugin.h>
+#include <opencv2/imgproc.hpp>
+#include "clahe_kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+/**
+ * Contrast limited adaptive histogram equalization on luma only.
+ *
+ * The frame is split into tiles x tiles regions. Each region gets a
+ * clip-limited equalization curve; curves are blended over time with an
+ * exponential moving average so the mapping does not flicker, then
+ * bilinearly interpolated per pixel. For color input the luma change is
+ * added to B, G and R, which keeps Cr/Cb untouched.
+ */
+class ClahePlugin : public QuinkOCPlugin {
+public:
+    bool init(const char *params, int nb_inputs, int nb_outputs) override {
+        if (nb_inputs != 1 || nb_outputs != 1)
+            return false;  // Only supports 1 input and 1 output
+        if (!params || !params[0]) return true;
+
+        const char *pos = strstr(params, "clip=");
+        if (pos) {
+            clip_limit_ = atof(pos + 5);
+            if (clip_limit_ < 1.0)
+                clip_limit_ = 1.0;
+            if (clip_limit_ > 40.0)
+                clip_limit_ = 40.0;
+        }
+
+        pos = strstr(params, "tiles=");
+        if (pos) {
+            tiles_ = atoi(pos + 6);
+            if (tiles_ < 1)
+                tiles_ = 1;
+            if (tiles_ > 32)
+                tiles_ = 32;
+        }
+
+        pos = strstr(params, "smooth=");
+        if (pos) {
+            smooth_ = static_cast<float>(atof(pos + 7));
+            if (smooth_ < 0.0f)
+                smooth_ = 0.0f;
+            if (smooth_ > 0.99f)
+                smooth_ = 0.99f;
+        }
+        return true;
+    }
+
+    QuinkOCProcessResult process(const std::vector<cv::Mat> &inputs,
+                                 std::vector<cv::Mat> &outputs) override {
+        if (inputs.empty() || outputs.empty())
+            return QUINK_OC_ERROR;
+
+        const cv::Mat &src = inputs[0];
+        if (src.cols != width_ || src.rows != height_ || src.depth() != CV_8U)
+            return QUINK_OC_ERROR;
+
+        cv::Mat luma;
+        switch (src.channels()) {
+        case 1:
+            luma = src;
+            break;
+        case 3:
+            cv::cvtColor(src, luma_, cv::COLOR_BGR2GRAY);
+            luma = luma_;
+            break;
+        case 4:
+            cv::cvtColor(src, luma_, cv::COLOR_BGRA2GRAY);
+            luma = luma_;
+            break;
+        default:
+            return QUINK_OC_ERROR;
+        }
+
+        buildLuts(luma);
+        applyLuts(src, luma, outputs[0]);
+        return QUINK_OC_OK;
+    }
+
+    bool flush(std::vector<cv::Mat> &) override {
+        return false;
+    }
+
+    bool configure(const std::vector<QuinkOCFrameConfig> &inputs,
+                   std::vector<QuinkOCFrameConfig> &outputs) override {
+        (void)outputs;
+        if (inputs.empty())
+            return false;
+
+        const QuinkOCFrameConfig &in = inputs[0];
+        if (in.cv_type != CV_8UC1 && in.cv_type != CV_8UC3 && in.cv_type != CV_8UC4)
+            return false;
+        if (in.width < tiles_ || in.height < tiles_)
+            return false;
+
+        width_ = in.width;
+        height_ = in.height;
+        luts_.assign(static_cast<size_t>(tiles_) * tiles_ * 256, 0.0f);
+        have_luts_ = false;
+
+        // Horizontal interpolation is the same for every row, so resolve the
+        // neighbouring tile columns and weights once.
+        col_tile0_.resize(width_);
+        col_tile1_.resize(width_);
+        col_weight_.resize(width_);
+        for (int x = 0; x < width_; x++) {
+            interpCoord(x, width_, col_tile0_[x], col_tile1_[x], col_weight_[x]);
+            col_tile0_[x] *= 256;
+            col_tile1_[x] *= 256;
+        }
+        return true;
+    }
+
+    void uninit() override {
+        luts_.clear();
+        luma_.release();
+    }
+
+    // The next frame's LUTs are used as they are rather than blended in
+    bool reset() override {
+        have_luts_ = false;
+        return true;
+    }
+
+private:
+    /** Tile t spans [tileStart(t), tileStart(t + 1)) of size pixels; none is empty */
+    int tileStart(int t, int size) const { return t * size / tiles_; }
+
+    void interpCoord(int pos, int size, int &t0, int &t1, float &w) const {
+        float f = (pos + 0.5f) * tiles_ / size - 0.5f;
+        int t = static_cast<int>(std::floor(f));
+        w = f - t;
+        t0 = std::max(t, 0);
+        t1 = std::min(t + 1, tiles_ - 1);
+        if (t < 0)
+            w = 0.0f;
+        if (t + 1 > tiles_ - 1)
+            w = 0.0f;
+    }
+
+    void buildLuts(const cv::Mat &luma) {
+        const float keep = have_luts_ ? smooth_ : 0.0f;
+
+        cv::parallel_for_(cv::Range(0, tiles_ * tiles_), [&](const cv::Range &range) {
+            int hist[256];
+            for (int t = range.start; t < range.end; t++) {
+                int tx = t % tiles_;
+                int ty = t / tiles_;
+                int x0 = tileStart(tx, width_);
+                int y0 = tileStart(ty, height_);
+                int x1 = tileStart(tx + 1, width_);
+                int y1 = tileStart(ty + 1, height_);
+                int area = (x1 - x0) * (y1 - y0);
+                float *lut = &luts_[static_cast<size_t>(t) * 256];
+
+                std::memset(hist, 0, sizeof(hist));
+                for (int y = y0; y < y1; y++) {
+                    const uchar *row = luma.ptr<uchar>(y);
+                    for (int x = x0; x < x1; x++)
+                        hist[row[x]]++;
+                }
+
+                // Clip and redistribute the excess evenly, the remainder
+                // spread with a stride like cv::CLAHE does.
+                int limit = std::max(1, static_cast<int>(clip_limit_ * area / 256));
+                int excess = 0;
+                for (int v = 0; v < 256; v++) {
+                    if (hist[v] > limit) {
+                        excess += hist[v] - limit;
+                        hist[v] = limit;
+                    }
+                }
+                int step = excess / 256;
+                int residual = excess - step * 256;
+                for (int v = 0; v < 256; v++)
+                    hist[v] += step;
+                if (residual > 0) {
+                    int stride = std::max(256 / residual, 1);
+                    for (int v = 0; v < 256 && residual > 0; v += stride, residual--)
+                        hist[v]++;
+                }
+
+                const float scale = 255.0f / area;
+                int cdf = 0;
+                for (int v = 0; v < 256; v++) {
+                    cdf += hist[v];
+                    lut[v] = keep * lut[v] + (1.0f - keep) * (cdf * scale);
+                }
+            }
+        });
+        have_luts_ = true;
+    }
+
+    void applyLuts(const cv::Mat &src, const cv::Mat &luma, cv::Mat &dst) const {
+        const int cn = src.channels();
+
+        cv::parallel_for_(cv::Range(0, height_), [&](const cv::Range &range) {
+            std::vector<float> buf(static_cast<size_t>(width_) * 5);
+            float *top_l = buf.data();
+            float *top_r = top_l + width_;
+            float *bot_l = top_r + width_;
+            float *bot_r = bot_l + width_;
+            float *delta = bot_r + width_;
+
+            for (int y = range.start; y < range.end; y++) {
+                int ty0, ty1;
+                float wy;
+                interpCoord(y, height_, ty0, ty1, wy);
+                const float *lut0 = &luts_[static_cast<size_t>(ty0) * tiles_ * 256];
+                const float *lut1 = &luts_[static_cast<size_t>(ty1) * tiles_ * 256];
+                const uchar *l = luma.ptr<uchar>(y);
+
+                // Table lookups are gathers; keep them in their own loop so
+                // the blend is a plain contiguous float loop that vectorizes.
+                for (int x = 0; x < width_; x++) {
+                    int v = l[x];
+                    top_l[x] = lut0[col_tile0_[x] + v];
+                    top_r[x] = lut0[col_tile1_[x] + v];
+                    bot_l[x] = lut1[col_tile0_[x] + v];
+                    bot_r[x] = lut1[col_tile1_[x] + v];
+                }
+
+                blend_row_(top_l, top_r, bot_l, bot_r, col_weight_.data(), wy, l, delta, width_);
+                apply_row_(src.ptr<uchar>(y), dst.ptr<uchar>(y), delta, width_, cn);
+            }
+        });
+    }
+
+    decltype(&isa_baseline::claheBlendRow) blend_row_ = QUINK_OC_DISPATCH(claheBlendRow);
+    decltype(&isa_baseline::claheApplyRow) apply_row_ = QUINK_OC_DISPATCH(claheApplyRow);
+
+    double clip_limit_ = 2.0;
+    int tiles_ = 8;
+    float smooth_ = 0.8f;
+
+    int width_ = 0;
+    int height_ = 0;
+    bool have_luts_ = false;
+    std::vector<float> luts_;
+    std::vector<int> col_tile0_;
+    std::vector<int> col_tile1_;
+    std::vector<float> col_weight_;
+    cv::Mat luma_;
+};
+
+QUINK_OC_PLUGIN_ENTRY(ClahePlugin, "clahe", "Temporally smoothed CLAHE on luma")
@@ -0,0 +1,83 @@
+#include "deinterlace_kernels.h"
+
+namespace QUINK_OC_ISA_NS {
+namespace {
+
+inline int absi(int v) { return v < 0 ? -v : v; }
+inline int maxi(int a, int b) { return a > b ? a : b; }
+inline int mini(int a, int b) { return a < b ? a : b; }
+
+/**
+ * Limit a spatial prediction to what the temporal neighbours allow
+ * (yadif-style): static areas take the temporal average, moving areas keep
+ * the spatial prediction.
+ */
+inline int temporalClamp(int pred, int c, int e, int p2, int n2,
+                         int pu, int pd, int nu, int nd, int b, int f) {
+    const int d = (p2 + n2) >> 1;
+    const int td0 = absi(p2 - n2) >> 1;
+    const int td1 = (absi(pu - c) + absi(pd - e)) >> 1;
+    const int td2 = (absi(nu - c) + absi(nd - e)) >> 1;
+    int diff = maxi(td0, maxi(td1, td2));
+
+    const int mx = maxi(d - e, maxi(d - c, mini(b - c, f - e)));
+    const int mn = mini(d - e, mini(d - c, maxi(b - c, f - e)));
+    diff = maxi(diff, maxi(mn, -mx));
+
+    pred = pred > d + diff ? d + diff : pred;
+    pred = pred < d - diff ? d - diff : pred;
+    return pred;
+}
+
+} // namespace
+
+// Row pointers are copied to locals and the inner loop is branch-free over
+// bytes so the compiler vectorizes it. Edge directions reach two pixels
+// sideways, so the first and last two pixels only use the vertical direction.
+void deintRow(uint8_t *__restrict dst, const DeintRow &r, int width_bytes, int cn) {
+    const uint8_t *u = r.cur_up;
+    const uint8_t *l = r.cur_dn;
+    const uint8_t *pu = r.prev_up;
+    const uint8_t *pd = r.prev_dn;
+    const uint8_t *nu = r.next_up;
+    const uint8_t *nd = r.next_dn;
+    const uint8_t *p2 = r.prev2;
+    const uint8_t *n2 = r.next2;
+    const uint8_t *p2u = r.prev2_up2;
+    const uint8_t *n2u = r.next2_up2;
+    const uint8_t *p2d = r.prev2_dn2;
+    const uint8_t *n2d = r.next2_dn2;
+
+    const int lo = mini(2 * cn, width_bytes);
+    const int hi = maxi(width_bytes - 2 * cn, lo);
+
+    for (int x = 0; x < width_bytes; x = (x + 1 == lo ? hi : x + 1)) {
+        const int c = u[x];
+        const int e = l[x];
+        dst[x] = static_cast<uint8_t>(temporalClamp((c + e) >> 1, c, e, p2[x], n2[x],
+                                                    pu[x], pd[x], nu[x], nd[x],
+                                                    (p2u[x] + n2u[x]) >> 1,
+                                                    (p2d[x] + n2d[x]) >> 1));
+    }
+
+    for (int x = lo; x < hi; x++) {
+        const int c = u[x];
+        const int e = l[x];
+        const int s0 = absi(u[x - cn] - l[x - cn]) + absi(c - e) + absi(u[x + cn] - l[x + cn]) - 1;
+        const int sm = absi(u[x - 2 * cn] - e) + absi(u[x - cn] - l[x + cn]) + absi(c - l[x + 2 * cn]);
+        const int sp = absi(c - l[x - 2 * cn]) + absi(u[x + cn] - l[x - cn]) + absi(u[x + 2 * cn] - e);
+
+        int pred = (c + e) >> 1;
+        int best = s0;
+        pred = sm < best ? (u[x - cn] + l[x + cn]) >> 1 : pred;
+        best = sm < best ? sm : best;
+        pred = sp < best ? (u[x + cn] + l[x - cn]) >> 1 : pred;
+
+        dst[x] = static_cast<uint8_t>(temporalClamp(pred, c, e, p2[x], n2[x],
+                                                    pu[x], pd[x], nu[x], nd[x],
+                                                    (p2u[x] + n2u[x]) >> 1,
+                                                    (p2d[x] + n2d[x]) >> 1));
+    }
+}
+
+} // namespace QUINK_OC_ISA_NS
@@ -0,0 +1,33 @@
+#ifndef QUINK_OC_DEINTERLACE_KERNELS_H
+#define QUINK_OC_DEINTERLACE_KERNELS_H
+
+#include "quink_oc_cpu.h"
+#include <cstdint>
+
+/** Row pointers around an interpolated line y (all frames are full frames). */
+struct DeintRow {
+    const uint8_t *cur_up;      ///< cur, line y - 1
+    const uint8_t *cur_dn;      ///< cur, line y + 1
+    const uint8_t *prev_up;     ///< prev, line y - 1
+    const uint8_t *prev_dn;     ///< prev, line y + 1
+    const uint8_t *next_up;     ///< next, line y - 1
+    const uint8_t *next_dn;     ///< next, line y + 1
+    const uint8_t *prev2;       ///< earlier neighbour of the missing field, line y
+    const uint8_t *next2;       ///< later neighbour of the missing field, line y
+    const uint8_t *prev2_up2;   ///< prev2, line y - 2
+    const uint8_t *next2_up2;   ///< next2, line y - 2
+    const uint8_t *prev2_dn2;   ///< prev2, line y + 2
+    const uint8_t *next2_dn2;   ///< next2, line y + 2
+};
+
+/**
+ * Interpolate one missing line. The spatial prediction picks the best of
+ * three edge directions, then a temporal clamp (yadif-style) decides how much
+ * motion there is: static areas take the temporal average, moving areas keep
+ * the spatial prediction.
+ *
+ * Pixel neighbours are cn bytes apart for interleaved formats.
+ */
+QUINK_OC_DECLARE_KERNEL(void, deintRow, (uint8_t *dst, const DeintRow &r, int width_bytes, int cn))
+
+#endif /* QUINK_OC_DEINTERLACE_KERNELS_H */
@@ -0,0 +1,157 @@
+#include <quink_oc_plugin.h>
+#include <opencv2/imgproc.hpp>
+#include "deinterlace_kernels.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+/**
+ * Motion adaptive deinterlacer, one output frame per input frame.
+ *
+ * Needs one frame of lookahead: the first call returns TRY_AGAIN and the
+ * last frame is emitted from flush(). Lines of the first field are copied,
+ * lines of the second field are interpolated in parallel stripes.
+ */
+class DeinterlacePlugin : public QuinkOCPlugin {
+public:
+    bool init(const char *params, int nb_inputs, int nb_outputs) override {
+        if (nb_inputs != 1 || nb_outputs != 1)
+            return false;  // Only supports 1 input and 1 output
+        if (!params || !params[0]) return true;
+
+        if (strstr(params, "parity=bff"))
+            tff_ = false;
+        return true;
+    }
+
+    QuinkOCProcessResult process(const std::vector<cv::Mat> &inputs,
+                                 std::vector<cv::Mat> &outputs) override {
+        if (inputs.empty() || outputs.empty())
+            return QUINK_OC_ERROR;
+
+        const cv::Mat &src = inputs[0];
+        if (src.depth() != CV_8U || src.size() != size_)
+            return QUINK_OC_ERROR;
+
+        if (retained_)
+            frames_[count_ % 3] = src;
+        else
+            src.copyTo(frames_[count_ % 3]);
+        count_++;
+        if (count_ < 2)
+            return QUINK_OC_TRY_AGAIN;
+
+        const long cur = count_ - 2;
+        filterFrame(frames_[(cur > 0 ? cur - 1 : cur) % 3], frames_[cur % 3],
+                    frames_[(cur + 1) % 3], outputs[0]);
+        return QUINK_OC_OK;
+    }
+
+    bool flush(std::vector<cv::Mat> &outputs) override {
+        if (count_ == 0 || flushed_ || outputs.empty())
+            return false;
+
+        const long cur = count_ - 1;
+        filterFrame(frames_[(cur > 0 ? cur - 1 : cur) % 3], frames_[cur % 3],
+                    frames_[cur % 3], outputs[0]);
+        flushed_ = true;
+        return true;
+    }
+
+    bool configure(const std::vector<QuinkOCFrameConfig> &inputs,
+                   std::vector<QuinkOCFrameConfig> &outputs) override {
+        (void)outputs;
+        if (inputs.empty())
+            return false;
+
+        const QuinkOCFrameConfig &in = inputs[0];
+        if (CV_MAT_DEPTH(in.cv_type) != CV_8U || in.height < 2)
+            return false;
+
+        size_ = cv::Size(in.width, in.height);
+        for (cv::Mat &f : frames_) {
+            if (retained_)
+                f.release();
+            else
+                f.create(in.height, in.width, in.cv_type);
+        }
+        count_ = 0;
+        flushed_ = false;
+        return true;
+    }
+
+    void uninit() override {
+        for (cv::Mat &f : frames_)
+            f.release();
+    }
+
+    bool reset() override {
+        // Copies are overwritten by the next frames, host frames are released
+        if (retained_) {
+            for (cv::Mat &f : frames_)
+                f.release();
+        }
+        count_ = 0;
+        flushed_ = false;
+        return true;
+    }
+
+    // Frame n is read until output n + 1, two calls later
+    int input_lookahead() const override { return 2; }
+
+    void retain_inputs(int depth) override { retained_ = depth >= 2; }
+
+private:
+    void filterFrame(const cv::Mat &prev, const cv::Mat &cur, const cv::Mat &next,
+                     cv::Mat &dst) const {
+        const int height = cur.rows;
+        const int width_bytes = cur.cols * cur.channels();
+        const int cn = cur.channels();
+        // Lines of the first field are kept, the others interpolated. The
+        // missing field is bracketed in time by the same field of prev and
+        // cur, whichever field order the source has.
+        const int keep = tff_ ? 0 : 1;
+        const cv::Mat &p2 = prev;
+        const cv::Mat &n2 = cur;
+
+        cv::parallel_for_(cv::Range(0, height), [&](const cv::Range &range) {
+            for (int y = range.start; y < range.end; y++) {
+                uchar *d = dst.ptr<uchar>(y);
+                if ((y & 1) == keep) {
+                    std::memcpy(d, cur.ptr<uchar>(y), width_bytes);
+                    continue;
+                }
+
+                const int up = y > 0 ? y - 1 : y + 1;
+                const int dn = y + 1 < height ? y + 1 : y - 1;
+                const int up2 = y >= 2 ? y - 2 : y;
+                const int dn2 = y + 2 < height ? y + 2 : y;
+
+                DeintRow r;
+                r.cur_up = cur.ptr<uchar>(up);
+                r.cur_dn = cur.ptr<uchar>(dn);
+                r.prev_up = prev.ptr<uchar>(up);
+                r.prev_dn = prev.ptr<uchar>(dn);
+                r.next_up = next.ptr<uchar>(up);
+                r.next_dn = next.ptr<uchar>(dn);
+                r.prev2 = p2.ptr<uchar>(y);
+                r.next2 = n2.ptr<uchar>(y);
+                r.prev2_up2 = p2.ptr<uchar>(up2);
+                r.next2_up2 = n2.ptr<uchar>(up2);
+                r.prev2_dn2 = p2.ptr<uchar>(dn2);
+                r.next2_dn2 = n2.ptr<uchar>(dn2);
+                deint_row_(d, r, width_bytes, cn);
+            }
+        }, height / 16.0);
+    }
+
+    decltype(&isa_baseline::deintRow) deint_row_ = QUINK_OC_DISPATCH(deintRow);
+    bool tff_ = true;
+    bool retained_ = false;  ///< frames_ are headers of host frames rather than copies
+    cv::Size size_;
+    cv::Mat frames_[3];
+    long count_ = 0;
+    bool flushed_ = false;
+};
+
+QUINK_OC_PLUGIN_ENTRY(DeinterlacePlugin, "deinterlace", "Motion adaptive deinterlacer")
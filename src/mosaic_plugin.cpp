@@ -0,0 +1,124 @@
+#include <quink_oc_plugin.h>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+/**
+ * Video wall: N inputs placed on a cols x rows grid.
+ *
+ * Each input is scaled straight into its cell of the output buffer (the
+ * destination ROI already has the target size and type, so cv::resize writes
+ * in place), with no per-input intermediate. Inputs are scaled concurrently.
+ */
+class MosaicPlugin : public QuinkOCPlugin {
+public:
+    bool init(const char *params, int nb_inputs, int nb_outputs) override {
+        if (nb_inputs < 1 || nb_inputs > 16 || nb_outputs != 1)
+            return false;  // Supports 1 to 16 inputs and 1 output
+        num_inputs_ = nb_inputs;
+        cols_ = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(nb_inputs))));
+        if (!params || !params[0]) return true;
+
+        const char *pos = strstr(params, "cols=");
+        if (pos) {
+            cols_ = atoi(pos + 5);
+            if (cols_ < 1)
+                cols_ = 1;
+            if (cols_ > nb_inputs)
+                cols_ = nb_inputs;
+        }
+
+        pos = strstr(params, "w=");
+        if (pos)
+            out_w_ = std::max(atoi(pos + 2), 0);
+
+        pos = strstr(params, "h=");
+        if (pos)
+            out_h_ = std::max(atoi(pos + 2), 0);
+        return true;
+    }
+
+    QuinkOCProcessResult process(const std::vector<cv::Mat> &inputs,
+                                 std::vector<cv::Mat> &outputs) override {
+        if (inputs.size() < static_cast<size_t>(num_inputs_) || outputs.empty())
+            return QUINK_OC_ERROR;
+
+        cv::Mat &out = outputs[0];
+        for (int i = 0; i < num_inputs_; i++) {
+            if (inputs[i].type() != out.type())
+                return QUINK_OC_ERROR;
+        }
+
+        for (const cv::Rect &r : blank_)
+            out(r).setTo(cv::Scalar::all(0));
+
+        cv::parallel_for_(cv::Range(0, num_inputs_), [&](const cv::Range &range) {
+            for (int i = range.start; i < range.end; i++) {
+                cv::Mat cell = out(cells_[i]);
+                if (inputs[i].size() == cell.size())
+                    inputs[i].copyTo(cell);
+                else
+                    cv::resize(inputs[i], cell, cell.size(), 0, 0, cv::INTER_AREA);
+            }
+        });
+        return QUINK_OC_OK;
+    }
+
+    bool flush(std::vector<cv::Mat> &) override {
+        return false;
+    }
+
+    bool configure(const std::vector<QuinkOCFrameConfig> &inputs,
+                   std::vector<QuinkOCFrameConfig> &outputs) override {
+        if (inputs.size() < static_cast<size_t>(num_inputs_) || outputs.empty())
+            return false;
+
+        for (int i = 1; i < num_inputs_; i++) {
+            if (inputs[i].cv_type != inputs[0].cv_type)
+                return false;
+        }
+
+        const int width = out_w_ > 0 ? out_w_ : inputs[0].width;
+        const int height = out_h_ > 0 ? out_h_ : inputs[0].height;
+        const int rows = (num_inputs_ + cols_ - 1) / cols_;
+        const int cell_w = width / cols_;
+        const int cell_h = height / rows;
+        if (cell_w < 1 || cell_h < 1)
+            return false;
+
+        outputs[0].width = width;
+        outputs[0].height = height;
+
+        cells_.clear();
+        for (int i = 0; i < num_inputs_; i++)
+            cells_.emplace_back((i % cols_) * cell_w, (i / cols_) * cell_h, cell_w, cell_h);
+
+        // Everything the cells don't cover: empty cells on the last row and
+        // the remainder strips when the size doesn't divide evenly.
+        blank_.clear();
+        for (int i = num_inputs_; i < rows * cols_; i++)
+            blank_.emplace_back((i % cols_) * cell_w, (i / cols_) * cell_h, cell_w, cell_h);
+        if (width > cols_ * cell_w)
+            blank_.emplace_back(cols_ * cell_w, 0, width - cols_ * cell_w, height);
+        if (height > rows * cell_h)
+            blank_.emplace_back(0, rows * cell_h, cols_ * cell_w, height - rows * cell_h);
+        return true;
+    }
+
+    void uninit() override {}
+
+    bool reset() override { return true; }
+
+private:
+    int num_inputs_ = 0;
+    int cols_ = 1;
+    int out_w_ = 0;
+    int out_h_ = 0;
+    std::vector<cv::Rect> cells_;
+    std::vector<cv::Rect> blank_;
+};
+
+QUINK_OC_PLUGIN_ENTRY_FLAGS(MosaicPlugin, "mosaic", "Video wall grid of N inputs",
+                            QUINK_OC_PLUGIN_FLAG_PURE)
@@ -0,0 +1,123 @@
+/*
+ * Runtime CPU feature dispatch for plugin kernels
+ *
+ * Hot kernels live in <name>_kernels.cpp, which the build compiles once per
+ * ISA level with QUINK_OC_ISA_NS set to isa_baseline, isa_sse42, isa_avx2 or
+ * isa_avx512 and the matching -m flags. The plugin picks the best compiled
+ * variant the CPU supports when it is created.
+ *
+ * Setting QUINK_OC_CPU=baseline|sse42|avx2|avx512 caps the selection, e.g.
+ * to compare variants or to test the fallback path on a newer machine.
+ *
+ * Kernel translation units must keep every helper in their ISA namespace or
+ * an unnamed namespace. Inline functions and templates with external
+ * linkage (std::min, std::max, ...) may be emitted out of line, and the
+ * linker is free to keep the AVX-512 copy for callers in baseline code.
+ */
+
+#ifndef QUINK_OC_CPU_H
+#define QUINK_OC_CPU_H
+
+#include <cstdlib>
+#include <cstring>
+
+#ifndef QUINK_OC_ISA_NS
+#define QUINK_OC_ISA_NS isa_baseline
+#endif
+
+enum QuinkOCIsa {
+    QUINK_OC_ISA_BASELINE = 0,
+    QUINK_OC_ISA_SSE42,
+    QUINK_OC_ISA_AVX2,
+    QUINK_OC_ISA_AVX512,
+};
+
+inline QuinkOCIsa quink_oc_detect_isa() {
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    // The avx512 objects are built with the avx2 flags too, and VMs may mask
+    // single features, so that level needs everything the avx2 one does.
+    const bool avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") &&
+                      __builtin_cpu_supports("bmi2");
+    if (avx2 && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+        __builtin_cpu_supports("avx512vl") && __builtin_cpu_supports("avx512dq"))
+        return QUINK_OC_ISA_AVX512;
+    if (avx2)
+        return QUINK_OC_ISA_AVX2;
+    if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt"))
+        return QUINK_OC_ISA_SSE42;
+#endif
+    return QUINK_OC_ISA_BASELINE;
+}
+
+/** Best ISA level of this CPU, capped by the QUINK_OC_CPU environment variable. */
+inline QuinkOCIsa quink_oc_cpu_isa() {
+    static const QuinkOCIsa isa = [] {
+        QuinkOCIsa detected = quink_oc_detect_isa();
+        const char *env = getenv("QUINK_OC_CPU");
+        if (!env || !env[0])
+            return detected;
+
+        QuinkOCIsa cap = detected;
+        if (!strcmp(env, "baseline"))
+            cap = QUINK_OC_ISA_BASELINE;
+        else if (!strcmp(env, "sse42"))
+            cap = QUINK_OC_ISA_SSE42;
+        else if (!strcmp(env, "avx2"))
+            cap = QUINK_OC_ISA_AVX2;
+        else if (!strcmp(env, "avx512"))
+            cap = QUINK_OC_ISA_AVX512;
+        return cap < detected ? cap : detected;
+    }();
+    return isa;
+}
+
+/** Highest compiled variant not above the CPU level; unbuilt variants are nullptr. */
+template <typename Fn>
+Fn quink_oc_select(Fn baseline, Fn sse42, Fn avx2, Fn avx512) {
+    const QuinkOCIsa isa = quink_oc_cpu_isa();
+    if (isa >= QUINK_OC_ISA_AVX512 && avx512)
+        return avx512;
+    if (isa >= QUINK_OC_ISA_AVX2 && avx2)
+        return avx2;
+    if (isa >= QUINK_OC_ISA_SSE42 && sse42)
+        return sse42;
+    return baseline;
+}
+
+/**
+ * Declare a kernel in every ISA namespace
+ *
+ * Usage: QUINK_OC_DECLARE_KERNEL(void, fooRow, (const uint8_t *src, int n))
+ */
+#define QUINK_OC_DECLARE_KERNEL(ret, name, args) \
+    namespace isa_baseline { ret name args; } \
+    namespace isa_sse42 { ret name args; } \
+    namespace isa_avx2 { ret name args; } \
+    namespace isa_avx512 { ret name args; }
+
+// The build defines QUINK_OC_HAVE_<ISA> for each level it compiled kernels for.
+#ifdef QUINK_OC_HAVE_SSE42
+#define QUINK_OC_ISA_FN_SSE42(name) &isa_sse42::name
+#else
+#define QUINK_OC_ISA_FN_SSE42(name) nullptr
+#endif
+#ifdef QUINK_OC_HAVE_AVX2
+#define QUINK_OC_ISA_FN_AVX2(name) &isa_avx2::name
+#else
+#define QUINK_OC_ISA_FN_AVX2(name) nullptr
+#endif
+#ifdef QUINK_OC_HAVE_AVX512
+#define QUINK_OC_ISA_FN_AVX512(name) &isa_avx512::name
+#else
+#define QUINK_OC_ISA_FN_AVX512(name) nullptr
+#endif
+
+/** Function pointer to the best variant of a kernel declared with QUINK_OC_DECLARE_KERNEL. */
+#define QUINK_OC_DISPATCH(name) \
+    quink_oc_select<decltype(&isa_baseline::name)>(&isa_baseline::name, \
+                                                   QUINK_OC_ISA_FN_SSE42(name), \
+                                                   QUINK_OC_ISA_FN_AVX2(name), \
+                                                   QUINK_OC_ISA_FN_AVX512(name))
+
+#endif /* QUINK_OC_CPU_H */
@@ -0,0 +1,126 @@
+/*
+ * Loading plugins from other plugins and tools
+ *
+ * The same lookup the oc_plugin filter does: open a library, prefer the
+ * descriptor enumeration entry point (which bundles export) and fall back to
+ * quink_oc_plugin_get_descriptor, then check the API version and look up the
+ * API level. Plugins built against an older level load too; see
+ * QUINK_OC_PLUGIN_API_LEVEL.
+ */
+
+#ifndef QUINK_OC_LOADER_H
+#define QUINK_OC_LOADER_H
+
+#include <quink_oc_plugin.h>
+#include <cstring>
+#include <string>
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+/** Directory of the library containing this code, with trailing separator, or empty */
+inline std::string quink_oc_own_directory() {
+    std::string path;
+#if defined(_WIN32) || defined(_WIN64)
+    HMODULE module = nullptr;
+    char buf[MAX_PATH];
+    if (GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS |
+                           GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                           reinterpret_cast<LPCSTR>(&quink_oc_own_directory), &module) &&
+        GetModuleFileNameA(module, buf, sizeof(buf)))
+        path = buf;
+#else
+    Dl_info info;
+    if (dladdr(reinterpret_cast<void *>(&quink_oc_own_directory), &info) && info.dli_fname)
+        path = info.dli_fname;
+#endif
+    size_t sep = path.find_last_of("/\\");
+    return sep == std::string::npos ? std::string() : path.substr(0, sep + 1);
+}
+
+/**
+ * Open a plugin library
+ *
+ * A bare file name that the system loader can't find is also looked up next
+ * to the calling library, so chained plugins can be installed side by side.
+ */
+inline void *quink_oc_library_open(const char *path) {
+#if defined(_WIN32) || defined(_WIN64)
+    void *lib = reinterpret_cast<void *>(LoadLibraryA(path));
+#else
+    void *lib = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+#endif
+    if (lib || strpbrk(path, "/\\"))
+        return lib;
+
+    std::string dir = quink_oc_own_directory();
+    if (dir.empty())
+        return nullptr;
+    std::string local = dir + path;
+#if defined(_WIN32) || defined(_WIN64)
+    return reinterpret_cast<void *>(LoadLibraryA(local.c_str()));
+#else
+    return dlopen(local.c_str(), RTLD_NOW | RTLD_LOCAL);
+#endif
+}
+
+inline void *quink_oc_library_symbol(void *lib, const char *symbol) {
+#if defined(_WIN32) || defined(_WIN64)
+    return reinterpret_cast<void *>(GetProcAddress(static_cast<HMODULE>(lib), symbol));
+#else
+    return dlsym(lib, symbol);
+#endif
+}
+
+inline void quink_oc_library_close(void *lib) {
+    if (!lib)
+        return;
+#if defined(_WIN32) || defined(_WIN64)
+    FreeLibrary(static_cast<HMODULE>(lib));
+#else
+    dlclose(lib);
+#endif
+}
+
+/** API level of a loaded library's plugins, at most QUINK_OC_PLUGIN_API_LEVEL */
+inline int quink_oc_library_api_level(void *lib) {
+    auto get_level = reinterpret_cast<QuinkOCPluginGetApiLevelFunc>(
+        quink_oc_library_symbol(lib, QUINK_OC_PLUGIN_LEVEL_SYMBOL));
+    const int level = get_level ? get_level() : 1;
+    if (level < 1)
+        return 1;
+    return level < QUINK_OC_PLUGIN_API_LEVEL ? level : QUINK_OC_PLUGIN_API_LEVEL;
+}
+
+/**
+ * Descriptor of a loaded library
+ *
+ * @param name   plugin to select from a bundle, NULL for the first one
+ * @param level  set to the plugin's API level, see quink_oc_library_api_level()
+ * @return NULL if there is no such plugin or its API version is unsupported
+ */
+inline const QuinkOCPluginDescriptor *quink_oc_library_descriptor(void *lib, const char *name,
+                                                                  int *level = nullptr) {
+    const QuinkOCPluginDescriptor *desc = nullptr;
+    auto enum_descriptors = reinterpret_cast<QuinkOCPluginEnumDescriptorsFunc>(
+        quink_oc_library_symbol(lib, QUINK_OC_PLUGIN_ENUM_SYMBOL));
+    auto get_descriptor = reinterpret_cast<QuinkOCPluginGetDescriptorFunc>(
+        quink_oc_library_symbol(lib, QUINK_OC_PLUGIN_DESCRIPTOR_SYMBOL));
+    if (enum_descriptors)
+        desc = quink_oc_find_descriptor(enum_descriptors, name);
+    else if (get_descriptor)
+        desc = get_descriptor();
+
+    if (!desc || desc->api_version != QUINK_OC_PLUGIN_API_VERSION)
+        return nullptr;
+    if (name && strcmp(desc->name, name))
+        return nullptr;
+    if (level)
+        *level = quink_oc_library_api_level(lib);
+    return desc;
+}
+
+#endif /* QUINK_OC_LOADER_H */
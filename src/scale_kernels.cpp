@@ -0,0 +1,47 @@
+#include "scale_kernels.h"
+
+namespace QUINK_OC_ISA_NS {
+namespace {
+
+/**
+ * Like cv::saturate_cast<uchar>: clamp, then round half to even. Adding and
+ * subtracting 2^23 leaves no fraction bits, so the FPU rounds to nearest even
+ * inline; std::nearbyint would be a libm call at the baseline level.
+ */
+inline uint8_t saturateU8(float v) {
+    v = v < 0.0f ? 0.0f : (v > 255.0f ? 255.0f : v);
+    return static_cast<uint8_t>((v + 0x1.0p23f) - 0x1.0p23f);
+}
+
+} // namespace
+
+void scaleVerticalPass(const uint8_t *const *rows, const float *w, int taps, float *tmp, int n) {
+    const uint8_t *r0 = rows[0];
+    const float w0 = w[0];
+    for (int x = 0; x < n; x++)
+        tmp[x] = w0 * r0[x];
+    for (int k = 1; k < taps; k++) {
+        const uint8_t *r = rows[k];
+        const float wk = w[k];
+        if (wk == 0.0f)
+            continue;
+        for (int x = 0; x < n; x++)
+            tmp[x] += wk * r[x];
+    }
+}
+
+void scaleHorizontalPass(const float *tmp, uint8_t *dst, const int *offsets, const float *w,
+                         int taps, int dst_w, int cn) {
+    for (int x = 0; x < dst_w; x++) {
+        const int *off = offsets + x * taps;
+        const float *wx = w + x * taps;
+        for (int c = 0; c < cn; c++) {
+            float acc = 0.0f;
+            for (int k = 0; k < taps; k++)
+                acc += wx[k] * tmp[off[k] + c];
+            dst[x * cn + c] = saturateU8(acc);
+        }
+    }
+}
+
+} // namespace QUINK_OC_ISA_NS
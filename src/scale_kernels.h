@@ -0,0 +1,19 @@
+#ifndef QUINK_OC_SCALE_KERNELS_H
+#define QUINK_OC_SCALE_KERNELS_H
+
+#include "quink_oc_cpu.h"
+#include <cstdint>
+
+/** tmp[x] = sum_k w[k] * rows[k][x] over one contiguous row of n bytes. */
+QUINK_OC_DECLARE_KERNEL(void, scaleVerticalPass,
+                        (const uint8_t *const *rows, const float *w, int taps, float *tmp, int n))
+
+/**
+ * dst[x * cn + c] = sum_k w[x * taps + k] * tmp[offsets[x * taps + k] + c],
+ * rounded and saturated. offsets are source byte offsets (index * cn).
+ */
+QUINK_OC_DECLARE_KERNEL(void, scaleHorizontalPass,
+                        (const float *tmp, uint8_t *dst, const int *offsets, const float *w,
+                         int taps, int dst_w, int cn))
+
+#endif /* QUINK_OC_SCALE_KERNELS_H */
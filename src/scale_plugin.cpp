@@ -0,0 +1,243 @@
+#include <quink_oc_plugin.h>
+#include <opencv2/imgproc.hpp>
+#include "scale_kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+enum ScaleFilter {
+    SCALE_BILINEAR,
+    SCALE_BICUBIC,
+    SCALE_LANCZOS,
+    SCALE_AREA,
+};
+
+/**
+ * Per output coordinate filter taps along one axis. Source indices are
+ * already clamped to the image (replicated border), so kernels never need
+ * bounds checks.
+ */
+struct FilterBank {
+    int taps = 0;
+    std::vector<int> index;     ///< dst_size * taps source indices
+    std::vector<float> weight;  ///< dst_size * taps normalized weights
+};
+
+double kernelRadius(ScaleFilter filter) {
+    switch (filter) {
+    case SCALE_BICUBIC: return 2.0;
+    case SCALE_LANCZOS: return 3.0;
+    default:            return 1.0;
+    }
+}
+
+double kernelWeight(ScaleFilter filter, double x) {
+    x = std::fabs(x);
+    switch (filter) {
+    case SCALE_BICUBIC: {
+        // Keys cubic, a = -0.5
+        const double a = -0.5;
+        if (x < 1.0)
+            return ((a + 2.0) * x - (a + 3.0)) * x * x + 1.0;
+        if (x < 2.0)
+            return ((a * x - 5.0 * a) * x + 8.0 * a) * x - 4.0 * a;
+        return 0.0;
+    }
+    case SCALE_LANCZOS: {
+        if (x < 1e-8)
+            return 1.0;
+        if (x >= 3.0)
+            return 0.0;
+        const double px = CV_PI * x;
+        return 3.0 * std::sin(px) * std::sin(px / 3.0) / (px * px);
+    }
+    default:
+        return x < 1.0 ? 1.0 - x : 0.0;
+    }
+}
+
+void buildBank(FilterBank &bank, ScaleFilter filter, int src_size, int dst_size) {
+    const double scale = static_cast<double>(src_size) / dst_size;
+    // Area on upscale degenerates to bilinear, as in cv::resize.
+    if (filter == SCALE_AREA && scale <= 1.0)
+        filter = SCALE_BILINEAR;
+
+    // Downscaling stretches the kernel over the source so it also acts as
+    // the anti-aliasing low-pass.
+    const double stretch = std::max(scale, 1.0);
+    const double support = filter == SCALE_AREA ? scale / 2.0 + 0.5
+                                                : kernelRadius(filter) * stretch;
+    bank.taps = static_cast<int>(std::ceil(support)) * 2 + 1;
+    bank.index.assign(static_cast<size_t>(dst_size) * bank.taps, 0);
+    bank.weight.assign(static_cast<size_t>(dst_size) * bank.taps, 0.0f);
+
+    std::vector<double> w(bank.taps);
+    for (int i = 0; i < dst_size; i++) {
+        const double center = (i + 0.5) * scale - 0.5;
+        const int first = static_cast<int>(std::floor(center)) - bank.taps / 2;
+        double sum = 0.0;
+        for (int k = 0; k < bank.taps; k++) {
+            const int j = first + k;
+            if (filter == SCALE_AREA) {
+                // Overlap of source pixel [j, j+1) with the destination
+                // footprint [i*scale, (i+1)*scale).
+                double lo = std::max<double>(j, i * scale);
+                double hi = std::min<double>(j + 1, (i + 1) * scale);
+                w[k] = std::max(hi - lo, 0.0);
+            } else {
+                w[k] = kernelWeight(filter, (j - center) / stretch);
+            }
+            sum += w[k];
+        }
+
+        int *idx = &bank.index[static_cast<size_t>(i) * bank.taps];
+        float *wt = &bank.weight[static_cast<size_t>(i) * bank.taps];
+        for (int k = 0; k < bank.taps; k++) {
+            idx[k] = std::min(std::max(first + k, 0), src_size - 1);
+            wt[k] = static_cast<float>(sum != 0.0 ? w[k] / sum : 0.0);
+        }
+    }
+}
+
+} // namespace
+
+/**
+ * Separable resize with precomputed filter banks.
+ *
+ * configure() builds per row/column tap tables for the chosen kernel. Each
+ * output row is produced by a vertical pass into a float row that stays in
+ * cache, immediately consumed by the horizontal pass; stripes of output rows
+ * run in parallel.
+ */
+class ScalePlugin : public QuinkOCPlugin {
+public:
+    bool init(const char *params, int nb_inputs, int nb_outputs) override {
+        if (nb_inputs != 1 || nb_outputs != 1)
+            return false;  // Only supports 1 input and 1 output
+        if (!params || !params[0]) return true;
+
+        const char *pos = strstr(params, "w=");
+        if (pos)
+            dst_w_ = std::max(atoi(pos + 2), 0);
+
+        pos = strstr(params, "h=");
+        if (pos)
+            dst_h_ = std::max(atoi(pos + 2), 0);
+
+        pos = strstr(params, "filter=");
+        if (pos) {
+            pos += 7;
+            if (!strncmp(pos, "bilinear", 8))
+                filter_ = SCALE_BILINEAR;
+            else if (!strncmp(pos, "bicubic", 7))
+                filter_ = SCALE_BICUBIC;
+            else if (!strncmp(pos, "lanczos", 7))
+                filter_ = SCALE_LANCZOS;
+            else if (!strncmp(pos, "area", 4))
+                filter_ = SCALE_AREA;
+            else
+                return false;
+        }
+        return true;
+    }
+
+    QuinkOCProcessResult process(const std::vector<cv::Mat> &inputs,
+                                 std::vector<cv::Mat> &outputs) override {
+        if (inputs.empty() || outputs.empty())
+            return QUINK_OC_ERROR;
+
+        const cv::Mat &src = inputs[0];
+        cv::Mat &dst = outputs[0];
+        if (src.cols != src_w_ || src.rows != src_h_ || src.depth() != CV_8U ||
+            src.channels() != cn_ || dst.cols != out_w_ || dst.rows != out_h_)
+            return QUINK_OC_ERROR;
+
+        if (src_w_ == out_w_ && src_h_ == out_h_) {
+            src.copyTo(dst);
+            return QUINK_OC_OK;
+        }
+
+        const int row_len = src_w_ * cn_;
+        cv::parallel_for_(cv::Range(0, out_h_), [&](const cv::Range &range) {
+            std::vector<float> tmp(row_len);
+            std::vector<const uchar *> rows(rows_.taps);
+            for (int y = range.start; y < range.end; y++) {
+                const int *idx = &rows_.index[static_cast<size_t>(y) * rows_.taps];
+                for (int k = 0; k < rows_.taps; k++)
+                    rows[k] = src.ptr<uchar>(idx[k]);
+                vertical_(rows.data(), &rows_.weight[static_cast<size_t>(y) * rows_.taps],
+                          rows_.taps, tmp.data(), row_len);
+                horizontal_(tmp.data(), dst.ptr<uchar>(y), col_offsets_.data(),
+                            cols_.weight.data(), cols_.taps, out_w_, cn_);
+            }
+        }, out_h_ / 16.0);
+        return QUINK_OC_OK;
+    }
+
+    bool flush(std::vector<cv::Mat> &) override {
+        return false;
+    }
+
+    bool configure(const std::vector<QuinkOCFrameConfig> &inputs,
+                   std::vector<QuinkOCFrameConfig> &outputs) override {
+        if (inputs.empty() || outputs.empty())
+            return false;
+
+        const QuinkOCFrameConfig &in = inputs[0];
+        if (CV_MAT_DEPTH(in.cv_type) != CV_8U || in.width < 1 || in.height < 1)
+            return false;
+
+        src_w_ = in.width;
+        src_h_ = in.height;
+        cn_ = CV_MAT_CN(in.cv_type);
+
+        // A missing dimension keeps the aspect ratio, rounded to even.
+        out_w_ = dst_w_;
+        out_h_ = dst_h_;
+        if (!out_w_ && !out_h_) {
+            out_w_ = src_w_;
+            out_h_ = src_h_;
+        } else if (!out_w_) {
+            out_w_ = std::max(2, static_cast<int>(std::lround(src_w_ * out_h_ / (2.0 * src_h_))) * 2);
+        } else if (!out_h_) {
+            out_h_ = std::max(2, static_cast<int>(std::lround(src_h_ * out_w_ / (2.0 * src_w_))) * 2);
+        }
+        outputs[0].width = out_w_;
+        outputs[0].height = out_h_;
+
+        buildBank(rows_, filter_, src_h_, out_h_);
+        buildBank(cols_, filter_, src_w_, out_w_);
+        col_offsets_.resize(cols_.index.size());
+        for (size_t i = 0; i < cols_.index.size(); i++)
+            col_offsets_[i] = cols_.index[i] * cn_;
+        return true;
+    }
+
+    void uninit() override {}
+
+    bool reset() override { return true; }
+
+private:
+    decltype(&isa_baseline::scaleVerticalPass) vertical_ = QUINK_OC_DISPATCH(scaleVerticalPass);
+    decltype(&isa_baseline::scaleHorizontalPass) horizontal_ = QUINK_OC_DISPATCH(scaleHorizontalPass);
+
+    int dst_w_ = 0;
+    int dst_h_ = 0;
+    ScaleFilter filter_ = SCALE_LANCZOS;
+
+    int src_w_ = 0;
+    int src_h_ = 0;
+    int out_w_ = 0;
+    int out_h_ = 0;
+    int cn_ = 0;
+    FilterBank rows_;
+    FilterBank cols_;
+    std::vector<int> col_offsets_;  ///< cols_.index scaled to byte offsets
+};
+
+QUINK_OC_PLUGIN_ENTRY_FLAGS(ScalePlugin, "scale", "Resize with precomputed filter banks",
+                            QUINK_OC_PLUGIN_FLAG_PURE)
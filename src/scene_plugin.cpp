@@ -0,0 +1,155 @@
+#include <quink_oc_plugin.h>
+#include <quink_oc_cadence.h>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+/**
+ * Scene change detection.
+ *
+ * Frames pass through untouched and get their score attached as metadata,
+ * "lavfi.quink.scene.score" from 0 to 100, plus "lavfi.quink.scene.change"
+ * set to 1 above the threshold. As in FFmpeg's scdet the score is the mean
+ * absolute difference to the previous frame, here on a downscaled luma
+ * proxy, less the previous frame's difference, so steady motion doesn't
+ * read as a cut. With a cadence (every=N, interval=MS) frames are compared
+ * to the last one analysed, and the frame after a cut is always analysed.
+ */
+class ScenePlugin : public QuinkOCPlugin {
+public:
+    bool init(const char *params, int nb_inputs, int nb_outputs) override {
+        if (nb_inputs != 1 || nb_outputs != 1)
+            return false;  // Only supports 1 input and 1 output
+        if (!params || !params[0]) return true;
+
+        const char *pos = strstr(params, "threshold=");
+        if (pos) {
+            threshold_ = atof(pos + 10);
+            if (threshold_ < 0.0)
+                threshold_ = 0.0;
+            if (threshold_ > 100.0)
+                threshold_ = 100.0;
+        }
+
+        pos = strstr(params, "scale=");
+        if (pos) {
+            scale_ = atoi(pos + 6);
+            if (scale_ < 1)
+                scale_ = 1;
+            if (scale_ > 16)
+                scale_ = 16;
+        }
+        return true;
+    }
+
+    QuinkOCProcessResult process(const std::vector<cv::Mat> &inputs,
+                                 std::vector<cv::Mat> &outputs) override {
+        if (inputs.empty() || outputs.empty())
+            return QUINK_OC_ERROR;
+
+        const cv::Mat &src = inputs[0];
+        if (!buildProxy(inputs))
+            return QUINK_OC_ERROR;
+
+        score_ = 0.0;
+        if (!prev_proxy_.empty()) {
+            cv::absdiff(proxy_, prev_proxy_, diff_);
+            const double mafd = cv::sum(diff_)[0] * 100.0 / (255.0 * diff_.total());
+            score_ = std::min(mafd, std::abs(mafd - prev_mafd_));
+            prev_mafd_ = mafd;
+        }
+        std::swap(prev_proxy_, proxy_);
+
+        outputs[0] = src;
+        return QUINK_OC_OK;
+    }
+
+    bool flush(std::vector<cv::Mat> &) override { return false; }
+
+    bool configure(const std::vector<QuinkOCFrameConfig> &inputs,
+                   std::vector<QuinkOCFrameConfig> &outputs) override {
+        (void)outputs;
+        if (inputs.empty())
+            return false;
+
+        const QuinkOCFrameConfig &in = inputs[0];
+        if (CV_MAT_DEPTH(in.cv_type) != CV_8U)
+            return false;
+
+        const QuinkOCFrameConfig proxy = quink_oc_proxy_config(in, scale_);
+        proxy_size_ = cv::Size(proxy.width, proxy.height);
+        // Either may be a host proxy, not to be resized into
+        proxy_.release();
+        prev_proxy_.release();
+        prev_mafd_ = 0.0;
+        return true;
+    }
+
+    void uninit() override {
+        proxy_.release();
+        prev_proxy_.release();
+    }
+
+    // The first frame of the new stream has nothing to compare to
+    bool reset() override {
+        prev_proxy_.release();
+        prev_mafd_ = 0.0;
+        score_ = 0.0;
+        return true;
+    }
+
+    void output_metadata(std::vector<QuinkOCMetadataEntry> &entries) override {
+        char value[32];
+        snprintf(value, sizeof(value), "%.3f", score_);
+        entries.push_back({0, "lavfi.quink.scene.score", value, false});
+        if (score_ >= threshold_)
+            entries.push_back({0, "lavfi.quink.scene.change", "1", false});
+    }
+
+    int proxy_scale() const override { return scale_; }
+
+    // The frame after a cut becomes the reference for the new scene
+    bool process_next() const override { return score_ >= threshold_; }
+
+private:
+    /** Luma proxy of inputs[0], the host's in inputs[1] if there is one */
+    bool buildProxy(const std::vector<cv::Mat> &inputs) {
+        if (inputs.size() > 1 && inputs[1].size() == proxy_size_ && inputs[1].type() == CV_8UC1) {
+            proxy_ = inputs[1];
+            return true;
+        }
+
+        const cv::Mat &src = inputs[0];
+        switch (src.channels()) {
+        case 1:
+            gray_ = src;
+            break;
+        case 3:
+            cv::cvtColor(src, gray_, cv::COLOR_BGR2GRAY);
+            break;
+        case 4:
+            cv::cvtColor(src, gray_, cv::COLOR_BGRA2GRAY);
+            break;
+        default:
+            return false;
+        }
+        cv::resize(gray_, proxy_, proxy_size_, 0, 0, cv::INTER_AREA);
+        return true;
+    }
+
+    double threshold_ = 10.0;
+    int scale_ = 4;
+
+    cv::Size proxy_size_;
+    cv::Mat gray_;
+    cv::Mat proxy_;
+    cv::Mat prev_proxy_;
+    cv::Mat diff_;
+    double prev_mafd_ = 0.0;
+    double score_ = 0.0;  ///< Of the frame last output
+};
+
+QUINK_OC_PLUGIN_ENTRY(QuinkOCCadence<ScenePlugin>, "scene", "Scene change scores as frame metadata")
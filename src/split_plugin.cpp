@@ -1,4 +1,5 @@
 #include <quink_oc_plugin.h>
+#include <quink_oc_frame_parallel.h>
 #include <opencv2/imgproc.hpp>
 #include <cstdlib>
 #include <cstring>
@@ -52,13 +53,44 @@ public:
             out.width = inputs[0].width;
             out.height = inputs[0].height;
         }
+        cv_type_ = inputs[0].cv_type;
         return true;
     }
 
     void uninit() override {}
 
+    bool reset() override { return true; }
+
+    void process_batch(const std::vector<std::vector<cv::Mat>> &inputs,
+                       std::vector<std::vector<cv::Mat>> &outputs,
+                       std::vector<QuinkOCProcessResult> &results) override {
+        process_batch_parallel(inputs, outputs, results);
+    }
+
+    void warmup(const std::vector<QuinkOCFrameConfig> &inputs,
+                const std::vector<QuinkOCFrameConfig> &outputs) override {
+        warmup_process(inputs, outputs);
+    }
+
+    // Only the pass-through + gray form is row-local; Canny isn't, and a lone
+    // pass-through is cheaper as a pass-through.
+    int row_halo() const override { return num_outputs_ == 2 && cv_type_ == CV_8UC3 ? 0 : -1; }
+
+    void process_rows(const std::vector<cv::Mat> &inputs, std::vector<cv::Mat> &outputs,
+                      int y0, int y1) override {
+        const cv::Mat src = inputs[0].rowRange(y0, y1);
+        cv::Mat copy = outputs[0].rowRange(y0, y1);
+        cv::Mat color = outputs[1].rowRange(y0, y1);
+        cv::Mat gray;
+        src.copyTo(copy);
+        cv::cvtColor(src, gray, cv::COLOR_BGR2GRAY);
+        cv::cvtColor(gray, color, cv::COLOR_GRAY2BGR);
+    }
+
 private:
     int num_outputs_ = 0;
+    int cv_type_ = 0;
 };
 
-QUINK_OC_PLUGIN_ENTRY(SplitPlugin, "split", "Single input to multiple outputs")
+QUINK_OC_PLUGIN_ENTRY_FLAGS(QuinkOCFrameParallel<SplitPlugin>, "split", "Single input to multiple outputs",
+                            QUINK_OC_PLUGIN_FLAG_PURE)
@@ -0,0 +1,200 @@
+#include <quink_oc_plugin.h>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+
+/**
+ * Single-pass translational video stabilization.
+ *
+ * Global motion between consecutive frames is estimated by phase correlation
+ * on a downscaled luma proxy. The accumulated camera path is smoothed with a
+ * centered moving average of +/- radius frames, so output lags input by
+ * radius frames (TRY_AGAIN while the lookahead fills, drained by flush()).
+ */
+class StabilizePlugin : public QuinkOCPlugin {
+public:
+    bool init(const char *params, int nb_inputs, int nb_outputs) override {
+        if (nb_inputs != 1 || nb_outputs != 1)
+            return false;  // Only supports 1 input and 1 output
+        if (!params || !params[0]) return true;
+
+        const char *pos = strstr(params, "radius=");
+        if (pos) {
+            radius_ = atoi(pos + 7);
+            if (radius_ < 1)
+                radius_ = 1;
+            if (radius_ > 60)
+                radius_ = 60;
+        }
+
+        pos = strstr(params, "scale=");
+        if (pos) {
+            scale_ = atoi(pos + 6);
+            if (scale_ < 1)
+                scale_ = 1;
+            if (scale_ > 16)
+                scale_ = 16;
+        }
+        return true;
+    }
+
+    QuinkOCProcessResult process(const std::vector<cv::Mat> &inputs,
+                                 std::vector<cv::Mat> &outputs) override {
+        if (inputs.empty() || outputs.empty())
+            return QUINK_OC_ERROR;
+
+        const cv::Mat &src = inputs[0];
+        if (!buildProxy(inputs))
+            return QUINK_OC_ERROR;
+
+        cv::Point2d pos(0.0, 0.0);
+        if (!path_.empty()) {
+            double response = 0.0;
+            cv::Point2d shift = cv::phaseCorrelate(prev_proxy_, proxy_, window_, &response);
+            pos = path_.back();
+            // Low peak response means no reliable match (scene cut, flat
+            // content); assume a static camera rather than jumping.
+            if (response > kMinResponse) {
+                pos.x += shift.x * scale_;
+                pos.y += shift.y * scale_;
+            }
+        }
+        std::swap(prev_proxy_, proxy_);
+
+        path_.push_back(pos);
+        pending_.push_back(retained_ ? src : src.clone());
+
+        if (static_cast<int>(pending_.size()) <= radius_)
+            return QUINK_OC_TRY_AGAIN;
+
+        emitFront(outputs[0]);
+        return QUINK_OC_OK;
+    }
+
+    bool flush(std::vector<cv::Mat> &outputs) override {
+        if (pending_.empty() || outputs.empty())
+            return false;
+
+        emitFront(outputs[0]);
+        return true;
+    }
+
+    bool configure(const std::vector<QuinkOCFrameConfig> &inputs,
+                   std::vector<QuinkOCFrameConfig> &outputs) override {
+        (void)outputs;
+        if (inputs.empty())
+            return false;
+
+        const QuinkOCFrameConfig &in = inputs[0];
+        if (CV_MAT_DEPTH(in.cv_type) != CV_8U)
+            return false;
+
+        const QuinkOCFrameConfig proxy = quink_oc_proxy_config(in, scale_);
+        proxy_size_ = cv::Size(proxy.width, proxy.height);
+        cv::createHanningWindow(window_, proxy_size_, CV_32F);
+        max_shift_ = cv::Point2d(in.width / 8.0, in.height / 8.0);
+        // Retained frames are only the host's until configure() returns
+        pending_.clear();
+        path_.clear();
+        return true;
+    }
+
+    void uninit() override {
+        pending_.clear();
+        path_.clear();
+    }
+
+    // Without a path the next frame starts a new one at the origin
+    bool reset() override {
+        pending_.clear();
+        path_.clear();
+        return true;
+    }
+
+    int input_lookahead() const override { return radius_; }
+
+    void retain_inputs(int depth) override { retained_ = depth >= radius_; }
+
+    int proxy_scale() const override { return scale_; }
+
+private:
+    /** Luma proxy of inputs[0], from the host's in inputs[1] if there is one */
+    bool buildProxy(const std::vector<cv::Mat> &inputs) {
+        if (inputs.size() > 1 && inputs[1].size() == proxy_size_ && inputs[1].channels() == 1) {
+            inputs[1].convertTo(proxy_, CV_32F);
+            return true;
+        }
+
+        const cv::Mat &src = inputs[0];
+        switch (src.channels()) {
+        case 1:
+            gray_ = src;
+            break;
+        case 3:
+            cv::cvtColor(src, gray_, cv::COLOR_BGR2GRAY);
+            break;
+        case 4:
+            cv::cvtColor(src, gray_, cv::COLOR_BGRA2GRAY);
+            break;
+        default:
+            return false;
+        }
+        cv::resize(gray_, small_, proxy_size_, 0, 0, cv::INTER_AREA);
+        small_.convertTo(proxy_, CV_32F);
+        return true;
+    }
+
+    void emitFront(cv::Mat &output) {
+        // path_ starts radius frames before the frame being emitted once the
+        // lookahead is warm; before that it starts at frame 0.
+        const int k = static_cast<int>(path_.size() - pending_.size());
+        const int first = std::max(k - radius_, 0);
+        const int last = std::min(k + radius_, static_cast<int>(path_.size()) - 1);
+
+        cv::Point2d smooth(0.0, 0.0);
+        for (int i = first; i <= last; i++) {
+            smooth.x += path_[i].x;
+            smooth.y += path_[i].y;
+        }
+        smooth.x /= (last - first + 1);
+        smooth.y /= (last - first + 1);
+
+        double tx = std::max(-max_shift_.x, std::min(max_shift_.x, smooth.x - path_[k].x));
+        double ty = std::max(-max_shift_.y, std::min(max_shift_.y, smooth.y - path_[k].y));
+
+        const cv::Mat &frame = pending_.front();
+        if (std::abs(tx) < 1e-3 && std::abs(ty) < 1e-3) {
+            frame.copyTo(output);
+        } else {
+            double m[6] = { 1.0, 0.0, tx, 0.0, 1.0, ty };
+            cv::Mat affine(2, 3, CV_64F, m);
+            cv::warpAffine(frame, output, affine, frame.size(),
+                           cv::INTER_LINEAR, cv::BORDER_REPLICATE);
+        }
+
+        pending_.pop_front();
+        if (k + 1 > radius_)
+            path_.pop_front();
+    }
+
+    static constexpr double kMinResponse = 0.05;
+
+    int radius_ = 15;
+    int scale_ = 4;
+    bool retained_ = false;  ///< Pending frames are host frames rather than copies
+
+    cv::Size proxy_size_;
+    cv::Point2d max_shift_;
+    cv::Mat window_;
+    cv::Mat gray_;
+    cv::Mat small_;
+    cv::Mat proxy_;
+    cv::Mat prev_proxy_;
+    std::deque<cv::Mat> pending_;
+    std::deque<cv::Point2d> path_;
+};
+
+QUINK_OC_PLUGIN_ENTRY(StabilizePlugin, "stabilize", "Single-pass lookahead video stabilization")
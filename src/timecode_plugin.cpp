@@ -0,0 +1,224 @@
+#include <quink_oc_plugin.h>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+/**
+ * Timecode / label burn-in.
+ *
+ * All glyphs that can appear are rasterized once in init() into a
+ * premultiplied BGRA atlas of fixed-size cells (with a drop shadow). The text
+ * line is kept composed in a small strip; per frame only the cells whose
+ * character changed are re-copied from the atlas, and only the strip rect is
+ * composited over the frame. The rest of the frame still costs a copy, since
+ * process() writes into a separate host output buffer, unless the host hands
+ * in the input frame itself as the output.
+ */
+class TimecodePlugin : public QuinkOCPlugin {
+public:
+    bool init(const char *params, int nb_inputs, int nb_outputs) override {
+        if (nb_inputs != 1 || nb_outputs != 1)
+            return false;  // Only supports 1 input and 1 output
+
+        // Whole keys only: the text itself may contain "x=" or "y="
+        for (const char *p = params; p && *p;) {
+            const size_t len = strcspn(p, ":");
+            const std::string item(p, len);
+            p += len + (p[len] ? 1 : 0);
+
+            const size_t eq = item.find('=');
+            if (eq == std::string::npos)
+                continue;
+            const std::string key = item.substr(0, eq);
+            const char *value = item.c_str() + eq + 1;
+
+            if (key == "text") {
+                label_ = value;
+            } else if (key == "rate") {
+                rate_ = std::min(std::max(atof(value), 1.0), 240.0);
+            } else if (key == "start") {
+                start_ = std::max(atol(value), 0L);
+                frame_ = start_;
+            } else if (key == "size") {
+                font_px_ = std::min(std::max(atoi(value), 8), 256);
+            } else if (key == "x") {
+                pos_x_ = std::max(atoi(value), 0);
+            } else if (key == "y") {
+                pos_y_ = std::max(atoi(value), 0);
+            }
+        }
+
+        buildAtlas();
+        return true;
+    }
+
+    QuinkOCProcessResult process(const std::vector<cv::Mat> &inputs,
+                                 std::vector<cv::Mat> &outputs) override {
+        if (inputs.empty() || outputs.empty())
+            return QUINK_OC_ERROR;
+
+        const cv::Mat &src = inputs[0];
+        cv::Mat &dst = outputs[0];
+        if (src.depth() != CV_8U || src.channels() == 2 || src.channels() > 4)
+            return QUINK_OC_ERROR;
+
+        updateStrip(currentText());
+        frame_++;
+
+        // The output is a separate host buffer, so everything outside the
+        // strip has to be copied; a host passing the input as the output
+        // (same data) gets only the strip written.
+        if (dst.data != src.data || dst.size() != src.size() || dst.type() != src.type())
+            src.copyTo(dst);
+        cv::Rect rect(pos_x_, pos_y_, strip_.cols, strip_.rows);
+        rect = rect & cv::Rect(0, 0, dst.cols, dst.rows);
+        if (rect.empty())
+            return QUINK_OC_OK;
+
+        const int cn = dst.channels();
+        for (int y = 0; y < rect.height; y++) {
+            const uchar *p = strip_.ptr<uchar>(y);
+            const uchar *s = src.ptr<uchar>(rect.y + y) + rect.x * cn;
+            uchar *d = dst.ptr<uchar>(rect.y + y) + rect.x * cn;
+            for (int x = 0; x < rect.width; x++, p += 4, s += cn, d += cn) {
+                const int inv = 255 - p[3];
+                if (cn == 1) {
+                    d[0] = static_cast<uchar>(p[0] + (s[0] * inv + 127) / 255);
+                    continue;
+                }
+                for (int c = 0; c < 3; c++)
+                    d[c] = static_cast<uchar>(p[c] + (s[c] * inv + 127) / 255);
+            }
+        }
+        return QUINK_OC_OK;
+    }
+
+    bool flush(std::vector<cv::Mat> &) override {
+        return false;
+    }
+
+    bool configure(const std::vector<QuinkOCFrameConfig> &inputs,
+                   std::vector<QuinkOCFrameConfig> &outputs) override {
+        (void)inputs;
+        (void)outputs;
+        return true;
+    }
+
+    void uninit() override {
+        atlas_.release();
+        strip_.release();
+    }
+
+    bool reset() override {
+        frame_ = start_;
+        return true;
+    }
+
+private:
+    static constexpr const char *kTimecodeGlyphs = "0123456789: ";
+
+    std::string currentText() const {
+        const long fps = std::max(1L, std::lround(rate_));
+        const long ff = frame_ % fps;
+        const long total = frame_ / fps;
+        char tc[32];
+        snprintf(tc, sizeof(tc), "%02ld:%02ld:%02ld:%02ld",
+                 (total / 3600) % 100, (total / 60) % 60, total % 60, ff);
+        return label_.empty() ? std::string(tc) : label_ + " " + tc;
+    }
+
+    int glyphIndex(char c) const {
+        size_t idx = glyphs_.find(c);
+        return idx == std::string::npos ? static_cast<int>(glyphs_.find(' ')) : static_cast<int>(idx);
+    }
+
+    void buildAtlas() {
+        glyphs_ = kTimecodeGlyphs;
+        for (char c : label_) {
+            if (glyphs_.find(c) == std::string::npos)
+                glyphs_ += c;
+        }
+
+        const int face = cv::FONT_HERSHEY_SIMPLEX;
+        const int thickness = std::max(1, font_px_ / 12);
+        const double scale = font_px_ / 30.0;
+        const int shadow = std::max(1, font_px_ / 16);
+
+        int baseline = 0;
+        cell_w_ = 1;
+        int ascent = 1;
+        for (char c : glyphs_) {
+            cv::Size sz = cv::getTextSize(std::string(1, c), face, scale, thickness, &baseline);
+            cell_w_ = std::max(cell_w_, sz.width);
+            ascent = std::max(ascent, sz.height);
+        }
+        cell_w_ += shadow + thickness;
+        cell_h_ = ascent + baseline + shadow + thickness;
+
+        const int n = static_cast<int>(glyphs_.size());
+        cv::Mat fg(cell_h_, cell_w_ * n, CV_8UC1, cv::Scalar(0));
+        cv::Mat bg(cell_h_, cell_w_ * n, CV_8UC1, cv::Scalar(0));
+        for (int i = 0; i < n; i++) {
+            std::string ch(1, glyphs_[i]);
+            cv::Point org(i * cell_w_, ascent);
+            cv::putText(bg, ch, cv::Point(org.x + shadow, org.y + shadow), face, scale,
+                        cv::Scalar(255), thickness, cv::LINE_AA);
+            cv::putText(fg, ch, org, face, scale, cv::Scalar(255), thickness, cv::LINE_AA);
+        }
+
+        // White text over a black shadow, stored premultiplied so the per
+        // frame composite is dst = atlas + src * (1 - alpha).
+        atlas_.create(cell_h_, cell_w_ * n, CV_8UC4);
+        for (int y = 0; y < atlas_.rows; y++) {
+            const uchar *f = fg.ptr<uchar>(y);
+            const uchar *b = bg.ptr<uchar>(y);
+            uchar *a = atlas_.ptr<uchar>(y);
+            for (int x = 0; x < atlas_.cols; x++, a += 4) {
+                int alpha = f[x] + (b[x] * (255 - f[x]) + 127) / 255;
+                a[0] = a[1] = a[2] = f[x];
+                a[3] = static_cast<uchar>(alpha);
+            }
+        }
+
+        strip_.release();
+        shown_.clear();
+    }
+
+    void updateStrip(const std::string &text) {
+        const int n = static_cast<int>(text.size());
+        if (strip_.empty() || strip_.cols != n * cell_w_) {
+            strip_.create(cell_h_, n * cell_w_, CV_8UC4);
+            shown_.assign(n, '\0');
+        }
+
+        for (int i = 0; i < n; i++) {
+            if (shown_[i] == text[i])
+                continue;
+            int g = glyphIndex(text[i]);
+            atlas_(cv::Rect(g * cell_w_, 0, cell_w_, cell_h_))
+                .copyTo(strip_(cv::Rect(i * cell_w_, 0, cell_w_, cell_h_)));
+            shown_[i] = text[i];
+        }
+    }
+
+    std::string label_;
+    double rate_ = 25.0;
+    long start_ = 0;
+    long frame_ = 0;
+    int font_px_ = 24;
+    int pos_x_ = 16;
+    int pos_y_ = 16;
+
+    std::string glyphs_;
+    int cell_w_ = 0;
+    int cell_h_ = 0;
+    cv::Mat atlas_;
+    cv::Mat strip_;
+    std::string shown_;
+};
+
+QUINK_OC_PLUGIN_ENTRY(TimecodePlugin, "timecode", "Timecode and label burn-in")
@@ -14,6 +14,7 @@ Environment Variables:
   FFMPEG_BIN   - Path to ffmpeg binary (default: ffmpeg in PATH)
   PLUGIN_DIR   - Directory containing plugins (default: ./build/src)
   OUTPUT_DIR   - Directory for output files (default: ./build/test_output)
+  BENCH_BIN    - Path to quink_oc_bench (default: tools/ next to PLUGIN_DIR)
 """
 
 import os
@@ -169,6 +170,19 @@ def run_ffmpeg(ffmpeg_bin: str, args: list) -> bool:
         print(f"Error running ffmpeg: {e}")
         return False
 
+def run_bench(bench_bin: str, args: list) -> bool:
+    """Run quink_oc_bench with given arguments, return True if successful."""
+    cmd = [bench_bin] + args
+    print(f"Command: {' '.join(cmd)}")
+    print()
+
+    try:
+        result = subprocess.run(cmd, check=False)
+        return result.returncode == 0
+    except Exception as e:
+        print(f"Error running quink_oc_bench: {e}")
+        return False
+
 def get_ffmpeg_version(ffmpeg_bin: str) -> str:
     """Get ffmpeg version string."""
     try:
@@ -212,6 +226,7 @@ Examples:
     ffmpeg_bin = args.ffmpeg or os.environ.get("FFMPEG_BIN", "ffmpeg")
     plugin_dir = args.plugin_dir or os.environ.get("PLUGIN_DIR", "./build/src")
     output_dir = args.output_dir or os.environ.get("OUTPUT_DIR", "./build/test_output")
+    bench_bin = os.environ.get("BENCH_BIN")
 
     # Get script directory for resolving relative paths
     script_dir = Path(__file__).parent.resolve()
@@ -235,6 +250,10 @@ Examples:
         print("Please build the plugins first or specify PLUGIN_DIR")
         sys.exit(1)
 
+    if not bench_bin:
+        bench_exe = "quink_oc_bench.exe" if plugin_ext == ".dll" else "quink_oc_bench"
+        bench_bin = os.path.join(os.path.dirname(plugin_dir), "tools", bench_exe)
+
     # Print configuration
     print("=" * 40)
     print("FFmpeg OpenCV Plugin Test Script")
@@ -244,6 +263,7 @@ Examples:
     print(f"FFmpeg binary: {ffmpeg_bin}")
     print(f"Plugin directory: {plugin_dir}")
     print(f"Output directory: {output_dir}")
+    print(f"Bench binary: {bench_bin}")
     print("=" * 40)
 
     # Check ffmpeg binary
@@ -279,7 +299,10 @@ Examples:
                     print(f"  Warning: Failed to copy {dep_file}: {e}")
 
         # Copy plugin files
-        for plugin_name in ["blur_plugin", "avgframes_plugin", "split_plugin", "blend_plugin"]:
+        for plugin_name in ["blur_plugin", "avgframes_plugin", "split_plugin", "blend_plugin",
+                            "clahe_plugin", "stabilize_plugin", "timecode_plugin",
+                            "mosaic_plugin", "deinterlace_plugin", "scale_plugin",
+                            "scene_plugin", "chain_plugin"]:
             plugin_file = f"lib{plugin_name}{plugin_ext}"
             src_path = os.path.join(plugin_dir, plugin_file)
             dst_path = os.path.join(ffmpeg_dir, plugin_file)
@@ -398,6 +421,351 @@ Examples:
     else:
         skipped += 1
 
+    # Test 5: CLAHE Plugin
+    print()
+    print("-" * 40)
+    print("Test 5: CLAHE Plugin")
+    print("-" * 40)
+    if check_plugin(plugin_dir, "clahe_plugin", plugin_ext):
+        success = run_ffmpeg(ffmpeg_bin, [
+            "-y", "-f", "lavfi",
+            "-i", f"testsrc=duration={DURATION}:size={WIDTH}x{HEIGHT}:rate={FPS}",
+            "-vf", f"oc_plugin=plugin={get_plugin('clahe_plugin')}:params='clip=3.0:tiles=8:smooth=0.8'",
+            f"{output_dir}/test_clahe.mp4"
+        ])
+        if success:
+            print(f"[PASS] CLAHE plugin test completed: {output_dir}/test_clahe.mp4")
+            passed += 1
+        else:
+            print("[FAIL] CLAHE plugin test failed")
+            failed += 1
+    else:
+        skipped += 1
+
+    # Test 6: Stabilize Plugin
+    print()
+    print("-" * 40)
+    print("Test 6: Stabilize Plugin")
+    print("-" * 40)
+    if check_plugin(plugin_dir, "stabilize_plugin", plugin_ext):
+        success = run_ffmpeg(ffmpeg_bin, [
+            "-y", "-f", "lavfi",
+            "-i", f"testsrc=duration={DURATION}:size={WIDTH}x{HEIGHT}:rate={FPS}",
+            "-vf", f"oc_plugin=plugin={get_plugin('stabilize_plugin')}:params='radius=10:scale=4'",
+            f"{output_dir}/test_stabilize.mp4"
+        ])
+        if success:
+            print(f"[PASS] Stabilize plugin test completed: {output_dir}/test_stabilize.mp4")
+            passed += 1
+        else:
+            print("[FAIL] Stabilize plugin test failed")
+            failed += 1
+    else:
+        skipped += 1
+
+    # Test 7: Timecode Plugin
+    print()
+    print("-" * 40)
+    print("Test 7: Timecode Plugin")
+    print("-" * 40)
+    if check_plugin(plugin_dir, "timecode_plugin", plugin_ext):
+        success = run_ffmpeg(ffmpeg_bin, [
+            "-y", "-f", "lavfi",
+            "-i", f"testsrc=duration={DURATION}:size={WIDTH}x{HEIGHT}:rate={FPS}",
+            "-vf", f"oc_plugin=plugin={get_plugin('timecode_plugin')}:params='text=CAM1:rate={FPS}:size=32'",
+            f"{output_dir}/test_timecode.mp4"
+        ])
+        if success:
+            print(f"[PASS] Timecode plugin test completed: {output_dir}/test_timecode.mp4")
+            passed += 1
+        else:
+            print("[FAIL] Timecode plugin test failed")
+            failed += 1
+    else:
+        skipped += 1
+
+    # Test 8: Mosaic Plugin (4 inputs -> 1 output)
+    print()
+    print("-" * 40)
+    print("Test 8: Mosaic Plugin (4 inputs)")
+    print("-" * 40)
+    if check_plugin(plugin_dir, "mosaic_plugin", plugin_ext):
+        success = run_ffmpeg(ffmpeg_bin, [
+            "-y",
+            "-f", "lavfi", "-i", f"testsrc=duration={DURATION}:size={WIDTH}x{HEIGHT}:rate={FPS}",
+            "-f", "lavfi", "-i", f"color=c=blue:duration={DURATION}:size={WIDTH}x{HEIGHT}:rate={FPS}",
+            "-f", "lavfi", "-i", f"testsrc2=duration={DURATION}:size={WIDTH}x{HEIGHT}:rate={FPS}",
+            "-f", "lavfi", "-i", f"color=c=red:duration={DURATION}:size=320x240:rate={FPS}",
+            "-filter_complex", f"[0:v][1:v][2:v][3:v]oc_plugin=plugin={get_plugin('mosaic_plugin')}:inputs=4:params='cols=2'",
+            f"{output_dir}/test_mosaic.mp4"
+        ])
+        if success:
+            print(f"[PASS] Mosaic plugin test completed: {output_dir}/test_mosaic.mp4")
+            passed += 1
+        else:
+            print("[FAIL] Mosaic plugin test failed")
+            failed += 1
+    else:
+        skipped += 1
+
+    # Test 9: Deinterlace Plugin
+    print()
+    print("-" * 40)
+    print("Test 9: Deinterlace Plugin")
+    print("-" * 40)
+    if check_plugin(plugin_dir, "deinterlace_plugin", plugin_ext):
+        success = run_ffmpeg(ffmpeg_bin, [
+            "-y", "-f", "lavfi",
+            "-i", f"testsrc=duration={DURATION}:size={WIDTH}x{HEIGHT}:rate={FPS * 2}",
+            "-vf", f"tinterlace=mode=interleave_top,oc_plugin=plugin={get_plugin('deinterlace_plugin')}:params=parity=tff",
+            f"{output_dir}/test_deinterlace.mp4"
+        ])
+        if success:
+            print(f"[PASS] Deinterlace plugin test completed: {output_dir}/test_deinterlace.mp4")
+            passed += 1
+        else:
+            print("[FAIL] Deinterlace plugin test failed")
+            failed += 1
+    else:
+        skipped += 1
+
+    # Test 10: Scale Plugin
+    print()
+    print("-" * 40)
+    print("Test 10: Scale Plugin")
+    print("-" * 40)
+    if check_plugin(plugin_dir, "scale_plugin", plugin_ext):
+        success = run_ffmpeg(ffmpeg_bin, [
+            "-y", "-f", "lavfi",
+            "-i", f"testsrc=duration={DURATION}:size={WIDTH}x{HEIGHT}:rate={FPS}",
+            "-vf", f"oc_plugin=plugin={get_plugin('scale_plugin')}:params='w=426:h=240:filter=lanczos'",
+            f"{output_dir}/test_scale.mp4"
+        ])
+        if success:
+            print(f"[PASS] Scale plugin test completed: {output_dir}/test_scale.mp4")
+            passed += 1
+        else:
+            print("[FAIL] Scale plugin test failed")
+            failed += 1
+    else:
+        skipped += 1
+
+    # Test 11: Chain Plugin (blur -> scale in one filter instance)
+    print()
+    print("-" * 40)
+    print("Test 11: Chain Plugin")
+    print("-" * 40)
+    if check_plugin(plugin_dir, "chain_plugin", plugin_ext):
+        stages = f"{get_plugin('blur_plugin')}?ksize=5|{get_plugin('scale_plugin')}?w=320:h=240:filter=area"
+        success = run_ffmpeg(ffmpeg_bin, [
+            "-y", "-f", "lavfi",
+            "-i", f"testsrc=duration={DURATION}:size={WIDTH}x{HEIGHT}:rate={FPS}",
+            "-vf", f"oc_plugin=plugin={get_plugin('chain_plugin')}:params='{stages}'",
+            f"{output_dir}/test_chain.mp4"
+        ])
+        if success:
+            print(f"[PASS] Chain plugin test completed: {output_dir}/test_chain.mp4")
+            passed += 1
+        else:
+            print("[FAIL] Chain plugin test failed")
+            failed += 1
+    else:
+        skipped += 1
+
+    # Test 12: Chain Plugin with fused stages (blend -> split gray, row tile by row tile)
+    print()
+    print("-" * 40)
+    print("Test 12: Chain Plugin (fused stages)")
+    print("-" * 40)
+    if check_plugin(plugin_dir, "chain_plugin", plugin_ext):
+        stages = f"{get_plugin('blend_plugin')}?alpha=0.3|{get_plugin('split_plugin')}@1x2"
+        success = run_ffmpeg(ffmpeg_bin, [
+            "-y",
+            "-f", "lavfi", "-i", f"testsrc=duration={DURATION}:size={WIDTH}x{HEIGHT}:rate={FPS}",
+            "-f", "lavfi", "-i", f"color=c=blue:duration={DURATION}:size={WIDTH}x{HEIGHT}:rate={FPS}",
+            "-filter_complex", f"[0:v][1:v]oc_plugin=plugin={get_plugin('chain_plugin')}:inputs=2:outputs=2:params='{stages}'[out0][out1]",
+            "-map", "[out0]", f"{output_dir}/test_chain_fused.mp4",
+            "-map", "[out1]", f"{output_dir}/test_chain_fused_gray.mp4"
+        ])
+        if success:
+            print(f"[PASS] Fused chain test completed: {output_dir}/test_chain_fused.mp4")
+            passed += 1
+        else:
+            print("[FAIL] Fused chain test failed")
+            failed += 1
+    else:
+        skipped += 1
+
+    # Test 13: Blur Plugin on several frames at once
+    print()
+    print("-" * 40)
+    print("Test 13: Blur Plugin (frame threads)")
+    print("-" * 40)
+    if check_plugin(plugin_dir, "blur_plugin", plugin_ext):
+        success = run_ffmpeg(ffmpeg_bin, [
+            "-y", "-f", "lavfi",
+            "-i", f"testsrc=duration={DURATION}:size={WIDTH}x{HEIGHT}:rate={FPS}",
+            "-vf", f"oc_plugin=plugin={get_plugin('blur_plugin')}:params='ksize=15:frame_threads=4'",
+            f"{output_dir}/test_blur_frame_threads.mp4"
+        ])
+        if success:
+            print(f"[PASS] Frame-parallel blur test completed: {output_dir}/test_blur_frame_threads.mp4")
+            passed += 1
+        else:
+            print("[FAIL] Frame-parallel blur test failed")
+            failed += 1
+    else:
+        skipped += 1
+
+    # Test 14: Average Frames Plugin on a worker thread
+    print()
+    print("-" * 40)
+    print("Test 14: Average Frames Plugin (async)")
+    print("-" * 40)
+    if check_plugin(plugin_dir, "avgframes_plugin", plugin_ext):
+        success = run_ffmpeg(ffmpeg_bin, [
+            "-y", "-f", "lavfi",
+            "-i", f"testsrc=duration={DURATION}:size={WIDTH}x{HEIGHT}:rate={FPS}",
+            "-vf", f"oc_plugin=plugin={get_plugin('avgframes_plugin')}:params='frames=5:async=4'",
+            f"{output_dir}/test_avgframes_async.mp4"
+        ])
+        if success:
+            print(f"[PASS] Async average frames test completed: {output_dir}/test_avgframes_async.mp4")
+            passed += 1
+        else:
+            print("[FAIL] Async average frames test failed")
+            failed += 1
+    else:
+        skipped += 1
+
+    # Test 15: Chain Plugin memoizing pure stages on a still source
+    print()
+    print("-" * 40)
+    print("Test 15: Chain Plugin (memo)")
+    print("-" * 40)
+    if check_plugin(plugin_dir, "chain_plugin", plugin_ext):
+        stages = f"memo=4|{get_plugin('blur_plugin')}?ksize=9|{get_plugin('scale_plugin')}?w=320:h=240"
+        success = run_ffmpeg(ffmpeg_bin, [
+            "-y", "-f", "lavfi",
+            "-i", f"color=c=blue:duration={DURATION}:size={WIDTH}x{HEIGHT}:rate={FPS}",
+            "-vf", f"oc_plugin=plugin={get_plugin('chain_plugin')}:params='{stages}'",
+            f"{output_dir}/test_chain_memo.mp4"
+        ])
+        if success:
+            print(f"[PASS] Memoized chain test completed: {output_dir}/test_chain_memo.mp4")
+            passed += 1
+        else:
+            print("[FAIL] Memoized chain test failed")
+            failed += 1
+    else:
+        skipped += 1
+
+    # Test 16: Scene Plugin (scores as frame metadata)
+    print()
+    print("-" * 40)
+    print("Test 16: Scene Plugin")
+    print("-" * 40)
+    if check_plugin(plugin_dir, "scene_plugin", plugin_ext):
+        success = run_ffmpeg(ffmpeg_bin, [
+            "-y", "-f", "lavfi",
+            "-i", f"testsrc=duration={DURATION}:size={WIDTH}x{HEIGHT}:rate={FPS}",
+            "-vf", f"oc_plugin=plugin={get_plugin('scene_plugin')}:params='threshold=10',metadata=mode=print",
+            f"{output_dir}/test_scene.mp4"
+        ])
+        if success:
+            print(f"[PASS] Scene plugin test completed: {output_dir}/test_scene.mp4")
+            passed += 1
+        else:
+            print("[FAIL] Scene plugin test failed")
+            failed += 1
+    else:
+        skipped += 1
+
+    # Test 17: Chain Plugin with analysis stages sharing one luma proxy
+    print()
+    print("-" * 40)
+    print("Test 17: Chain Plugin (shared proxies)")
+    print("-" * 40)
+    if check_plugin(plugin_dir, "chain_plugin", plugin_ext):
+        stages = f"{get_plugin('scene_plugin')}?scale=4|{get_plugin('stabilize_plugin')}?radius=5:scale=4"
+        success = run_ffmpeg(ffmpeg_bin, [
+            "-y", "-f", "lavfi",
+            "-i", f"testsrc=duration={DURATION}:size={WIDTH}x{HEIGHT}:rate={FPS}",
+            "-vf", f"oc_plugin=plugin={get_plugin('chain_plugin')}:params='{stages}'",
+            f"{output_dir}/test_chain_proxy.mp4"
+        ])
+        if success:
+            print(f"[PASS] Shared proxy chain test completed: {output_dir}/test_chain_proxy.mp4")
+            passed += 1
+        else:
+            print("[FAIL] Shared proxy chain test failed")
+            failed += 1
+    else:
+        skipped += 1
+
+    # Test 18: Scene Plugin analysing every 4th frame
+    print()
+    print("-" * 40)
+    print("Test 18: Scene Plugin (cadence)")
+    print("-" * 40)
+    if check_plugin(plugin_dir, "scene_plugin", plugin_ext):
+        success = run_ffmpeg(ffmpeg_bin, [
+            "-y", "-f", "lavfi",
+            "-i", f"testsrc=duration={DURATION}:size={WIDTH}x{HEIGHT}:rate={FPS}",
+            "-vf", f"oc_plugin=plugin={get_plugin('scene_plugin')}:params='threshold=10:every=4:repeat_metadata=1'",
+            f"{output_dir}/test_scene_cadence.mp4"
+        ])
+        if success:
+            print(f"[PASS] Scene cadence test completed: {output_dir}/test_scene_cadence.mp4")
+            passed += 1
+        else:
+            print("[FAIL] Scene cadence test failed")
+            failed += 1
+    else:
+        skipped += 1
+
+    # Test 19: Average Frames Plugin handing its state over to a new instance
+    # (the bench first checks the new instance refuses truncated and foreign states)
+    print()
+    print("-" * 40)
+    print("Test 19: Average Frames Plugin (state handover)")
+    print("-" * 40)
+    if check_plugin(plugin_dir, "avgframes_plugin", plugin_ext) and os.path.isfile(bench_bin):
+        success = run_bench(bench_bin, [
+            "-s", f"{WIDTH}x{HEIGHT}", "-f", "60", "-k", "17", "-p", "frames=5",
+            os.path.join(plugin_dir, f"libavgframes_plugin{plugin_ext}")
+        ])
+        if success:
+            print("[PASS] Average frames handover test completed")
+            passed += 1
+        else:
+            print("[FAIL] Average frames handover test failed")
+            failed += 1
+    else:
+        skipped += 1
+
+    # Test 20: Chain Plugin handing the state of all its stages over
+    print()
+    print("-" * 40)
+    print("Test 20: Chain Plugin (state handover)")
+    print("-" * 40)
+    if (check_plugin(plugin_dir, "chain_plugin", plugin_ext) and
+            check_plugin(plugin_dir, "avgframes_plugin", plugin_ext) and os.path.isfile(bench_bin)):
+        avgframes = os.path.join(plugin_dir, f"libavgframes_plugin{plugin_ext}")
+        success = run_bench(bench_bin, [
+            "-s", f"{WIDTH}x{HEIGHT}", "-f", "60", "-k", "17",
+            "-p", f"{avgframes}?frames=3|{avgframes}?frames=4",
+            os.path.join(plugin_dir, f"libchain_plugin{plugin_ext}")
+        ])
+        if success:
+            print("[PASS] Chain handover test completed")
+            passed += 1
+        else:
+            print("[FAIL] Chain handover test failed")
+            failed += 1
+    else:
+        skipped += 1
+
     # Print summary
     print()
     print("=" * 40)
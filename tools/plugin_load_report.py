@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+"""
+Plugin load report
+
+For every plugin library in a directory, prints the file size, the number of
+exported and imported dynamic symbols, and the time to dlopen it with
+immediate binding in a fresh process (median of several runs), which is what
+an ffmpeg process pays per plugin at startup.
+
+Usage:
+  python tools/plugin_load_report.py [-p ./build/src] [-n 11]
+
+Environment Variables:
+  PLUGIN_DIR   - Directory containing plugins (default: ./build/src)
+"""
+
+import os
+import sys
+import glob
+import platform
+import statistics
+import subprocess
+import argparse
+
+
+# Runs in a fresh interpreter so every sample loads OpenCV and the plugin cold
+# from the dynamic linker's point of view (page cache stays warm).
+LOAD_SNIPPET = r"""
+import ctypes, os, sys, time
+mode = getattr(os, "RTLD_NOW", 2) | getattr(os, "RTLD_LOCAL", 0)
+start = time.perf_counter()
+ctypes.CDLL(sys.argv[1], mode=mode)
+print((time.perf_counter() - start) * 1000.0)
+"""
+
+
+def plugin_ext():
+    system = platform.system()
+    if system == "Darwin":
+        return ".dylib"
+    if system == "Windows":
+        return ".dll"
+    return ".so"
+
+
+def count_symbols(path: str, defined: bool):
+    """Dynamic symbols defined (exported) or undefined (imported), None if nm is unusable."""
+    if platform.system() == "Darwin":
+        cmd = ["nm", "-gU", path] if defined else ["nm", "-gu", path]
+    elif platform.system() == "Windows":
+        return None
+    else:
+        cmd = ["nm", "-D", "--defined-only" if defined else "--undefined-only", path]
+    try:
+        out = subprocess.run(cmd, capture_output=True, text=True, check=True).stdout
+    except (subprocess.CalledProcessError, FileNotFoundError):
+        return None
+    return sum(1 for line in out.splitlines() if line.strip())
+
+
+def load_time_ms(path: str, runs: int):
+    samples = []
+    for _ in range(runs):
+        result = subprocess.run([sys.executable, "-c", LOAD_SNIPPET, path],
+                                capture_output=True, text=True, check=False)
+        if result.returncode != 0:
+            return None
+        samples.append(float(result.stdout.strip()))
+    return statistics.median(samples)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Plugin load time and exported symbol report")
+    parser.add_argument("-p", "--plugin-dir", help="Plugin directory")
+    parser.add_argument("-n", "--runs", type=int, default=11, help="Load samples per plugin")
+    args = parser.parse_args()
+
+    plugin_dir = args.plugin_dir or os.environ.get("PLUGIN_DIR", "./build/src")
+    if not os.path.isdir(plugin_dir):
+        print(f"Error: Plugin directory not found: {plugin_dir}")
+        sys.exit(1)
+
+    ext = plugin_ext()
+    libs = sorted(glob.glob(os.path.join(plugin_dir, f"lib*_plugin{ext}")) +
+                  glob.glob(os.path.join(plugin_dir, f"libquink_oc_bundle{ext}")))
+    if not libs:
+        print(f"Error: No plugins found in {plugin_dir}")
+        sys.exit(1)
+
+    def fmt(value, spec):
+        return "n/a" if value is None else format(value, spec)
+
+    print(f"{'library':<32} {'size KiB':>9} {'exported':>9} {'imported':>9} {'load ms':>9}")
+    print("-" * 72)
+    total_ms = 0.0
+    for lib in libs:
+        size_kib = os.path.getsize(lib) / 1024.0
+        exported = count_symbols(lib, True)
+        imported = count_symbols(lib, False)
+        ms = load_time_ms(lib, max(1, args.runs))
+        if ms is not None and "bundle" not in lib:
+            total_ms += ms
+        print(f"{os.path.basename(lib):<32} {size_kib:>9.1f} {fmt(exported, '>9d')} "
+              f"{fmt(imported, '>9d')} {fmt(ms, '>9.2f')}")
+    print("-" * 72)
+    print(f"Sum of single plugin load times: {total_ms:.2f} ms")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,400 @@
+/*
+ * Plugin benchmark and host emulator
+ *
+ * Loads a plugin library the way FFmpeg's oc_plugin filter does, feeds it
+ * synthetic frames and reports throughput. Used on its own to compare builds
+ * and by the PGO training step.
+ *
+ * Usage: quink_oc_bench [options] <plugin library>
+ *   -n name     plugin to select from a bundle library (default: first)
+ *   -p params   plugin parameter string
+ *   -s WxH      input frame size (default 1920x1080)
+ *   -c cn       channels of the 8-bit input frames: 1, 3 or 4 (default 3)
+ *   -i N        number of inputs (default 1)
+ *   -o N        number of outputs (default 1)
+ *   -f N        number of frames (default 100)
+ *   -r N        input frames retained for the plugin (default: as many as it asks for)
+ *   -b N        streams batched per call, pure plugins only (default 1)
+ *   -w 0|1      call the plugin's warmup() before the first frame (default 1)
+ *   -g N        frames per segment: flush and reset() the plugin every N frames
+ *   -k N        hand over after N frames: save_state() and go on with a new
+ *               instance that load_state()s it, after checking that it
+ *               refuses the state cut short or with a foreign header
+ *
+ * Besides throughput it reports the setup time, from creating the plugin
+ * to the end of warmup(), and the time from the first frame to the first
+ * output, where lazy initialization and first-touch page faults show. With
+ * segments it also reports the time reset() takes, to compare with setup,
+ * and with a handover the state size and the time to save and to load it.
+ */
+
+#include <quink_oc_plugin.h>
+#include <quink_oc_proxy.h>
+#include <quink_oc_state.h>
+#include "quink_oc_loader.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct BenchOptions {
+    const char *library = nullptr;
+    const char *name = nullptr;
+    const char *params = nullptr;
+    int width = 1920;
+    int height = 1080;
+    int channels = 3;
+    int nb_inputs = 1;
+    int nb_outputs = 1;
+    int frames = 100;
+    int retain = -1;  ///< -1 for the plugin's input_lookahead()
+    int streams = 1;  ///< Frame sets per process_batch() call, 1 for process()
+    bool warmup = true;
+    int segment = 0;  ///< Frames per segment, 0 for one stream
+    int handover = 0; ///< Frames before saving the state into a new instance, 0 for none
+};
+
+void usage() {
+    fprintf(stderr,
+            "Usage: quink_oc_bench [options] <plugin library>\n"
+            "  -n name     plugin to select from a bundle library\n"
+            "  -p params   plugin parameter string\n"
+            "  -s WxH      input frame size (default 1920x1080)\n"
+            "  -c cn       input channels: 1, 3 or 4 (default 3)\n"
+            "  -i N        number of inputs (default 1)\n"
+            "  -o N        number of outputs (default 1)\n"
+            "  -f N        number of frames (default 100)\n"
+            "  -r N        input frames retained (default: plugin's lookahead)\n"
+            "  -b N        streams batched per call, pure plugins only (default 1)\n"
+            "  -w 0|1      call warmup() before the first frame (default 1)\n"
+            "  -g N        flush and reset() the plugin every N frames\n"
+            "  -k N        after N frames, go on with a new instance loading the state\n");
+}
+
+bool parseOptions(int argc, char **argv, BenchOptions &opts) {
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (arg[0] != '-' || !arg[1] || arg[2]) {
+            if (opts.library)
+                return false;
+            opts.library = arg;
+            continue;
+        }
+        if (i + 1 >= argc)
+            return false;
+        const char *val = argv[++i];
+        switch (arg[1]) {
+        case 'n': opts.name = val; break;
+        case 'p': opts.params = val; break;
+        case 's':
+            if (sscanf(val, "%dx%d", &opts.width, &opts.height) != 2)
+                return false;
+            break;
+        case 'c': opts.channels = atoi(val); break;
+        case 'i': opts.nb_inputs = atoi(val); break;
+        case 'o': opts.nb_outputs = atoi(val); break;
+        case 'f': opts.frames = atoi(val); break;
+        case 'r': opts.retain = atoi(val); break;
+        case 'b': opts.streams = atoi(val); break;
+        case 'w': opts.warmup = atoi(val) != 0; break;
+        case 'g': opts.segment = atoi(val); break;
+        case 'k': opts.handover = atoi(val); break;
+        default: return false;
+        }
+    }
+    return opts.library && opts.width > 0 && opts.height > 0 && opts.nb_inputs > 0 &&
+           opts.nb_outputs > 0 && opts.frames > 0 && opts.streams > 0 && opts.segment >= 0 && opts.handover >= 0 &&
+           (opts.channels == 1 || opts.channels == 3 || opts.channels == 4);
+}
+
+const QuinkOCPluginDescriptor *loadDescriptor(const BenchOptions &opts, int &level) {
+    void *lib = quink_oc_library_open(opts.library);
+    if (!lib) {
+        fprintf(stderr, "Failed to load %s\n", opts.library);
+        return nullptr;
+    }
+
+    const QuinkOCPluginDescriptor *desc = quink_oc_library_descriptor(lib, opts.name, &level);
+    if (!desc)
+        fprintf(stderr, "No plugin %s with API version %d in %s\n", opts.name ? opts.name : "",
+                QUINK_OC_PLUGIN_API_VERSION, opts.library);
+    return desc;
+}
+
+/** Create, initialize and configure an instance, nullptr on failure; out_cfg gets the outputs */
+QuinkOCPlugin *openPlugin(const QuinkOCPluginDescriptor *desc, int level, const BenchOptions &opts,
+                          const std::vector<QuinkOCFrameConfig> &in_cfg,
+                          std::vector<QuinkOCFrameConfig> &out_cfg) {
+    QuinkOCPlugin *plugin = desc->create();
+    if (!plugin || !plugin->init(opts.params, opts.nb_inputs, opts.nb_outputs)) {
+        fprintf(stderr, "%s: init failed\n", desc->name);
+        if (plugin)
+            desc->destroy(plugin);
+        return nullptr;
+    }
+
+    // The source frames live for the whole run, any depth can be retained
+    if (level >= 4)
+        plugin->retain_inputs(opts.retain < 0 ? plugin->input_lookahead() : opts.retain);
+
+    if (!plugin->configure(in_cfg, out_cfg)) {
+        fprintf(stderr, "%s: configure failed\n", desc->name);
+        plugin->uninit();
+        desc->destroy(plugin);
+        return nullptr;
+    }
+    return plugin;
+}
+
+/** Textured frame with a diagonal drift per index, so temporal plugins see motion */
+/**
+ * Whether plugin refuses blobs it can't have saved: state cut short, state
+ * with another magic number, or another plugin's empty state. A refused blob
+ * leaves the plugin as configure() left it, so it can load state afterwards.
+ */
+bool refusesBadStates(QuinkOCPlugin *plugin, const std::vector<uint8_t> &state) {
+    if (state.empty())
+        return true;
+    std::vector<uint8_t> foreign;
+    QuinkOCStateWriter(foreign, "quink_oc_bench");
+    std::vector<uint8_t> bad_magic(state);
+    bad_magic[0] ^= 0xff;
+    return !plugin->load_state(state.data(), state.size() - 1) &&
+           !plugin->load_state(state.data(), state.size() / 2) &&
+           !plugin->load_state(bad_magic.data(), bad_magic.size()) &&
+           !plugin->load_state(foreign.data(), foreign.size());
+}
+
+void fillFrame(cv::Mat &frame, int index, int input) {
+    const int cn = frame.channels();
+    for (int y = 0; y < frame.rows; y++) {
+        uchar *p = frame.ptr<uchar>(y);
+        for (int x = 0; x < frame.cols; x++) {
+            const int u = x + index * 3 + input * 17;
+            const int v = y + index * 2;
+            const int base = ((u >> 3) ^ (v >> 3)) & 1 ? 160 : 64;
+            for (int c = 0; c < cn; c++)
+                p[x * cn + c] = static_cast<uchar>(base + ((u * 7 + v * 13 + c * 29) & 31));
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    BenchOptions opts;
+    if (!parseOptions(argc, argv, opts)) {
+        usage();
+        return 1;
+    }
+
+    int level = 1;
+    const QuinkOCPluginDescriptor *desc = loadDescriptor(opts, level);
+    if (!desc)
+        return 1;
+
+    if (opts.streams > 1 && (level < 3 || !(desc->flags & QUINK_OC_PLUGIN_FLAG_PURE))) {
+        fprintf(stderr, "%s: only pure plugins can be batched\n", desc->name);
+        return 1;
+    }
+    if (opts.segment > 0 && (opts.streams > 1 || level < 11)) {
+        fprintf(stderr, "%s: segments need reset() and no batching\n", desc->name);
+        return 1;
+    }
+    if (opts.handover > 0 && (opts.streams > 1 || level < 12)) {
+        fprintf(stderr, "%s: handover needs save_state() and no batching\n", desc->name);
+        return 1;
+    }
+
+    // Same defaults as the host: output[i] = input[i], or input[0].
+    const int cv_type = CV_8UC(opts.channels);
+    std::vector<QuinkOCFrameConfig> in_cfg(opts.nb_inputs, {opts.width, opts.height, cv_type});
+    std::vector<QuinkOCFrameConfig> default_out;
+    for (int i = 0; i < opts.nb_outputs; i++)
+        default_out.push_back(in_cfg[i < opts.nb_inputs ? i : 0]);
+    std::vector<QuinkOCFrameConfig> out_cfg(default_out);
+
+    const auto setup_start = std::chrono::steady_clock::now();
+    QuinkOCPlugin *plugin = openPlugin(desc, level, opts, in_cfg, out_cfg);
+    if (!plugin)
+        return 1;
+    const auto configured = std::chrono::steady_clock::now();
+
+    // Frames are allocated the way the plugin asks for, as the host does
+    QuinkOCFrameLayout layout = {1, 0};
+    if (level >= 5)
+        layout = plugin->frame_layout();
+
+    // A short ring of distinct source frames per input
+    const int ring = 8;
+    std::vector<std::vector<cv::Mat>> sources(ring, std::vector<cv::Mat>(opts.nb_inputs));
+    for (int f = 0; f < ring; f++) {
+        for (int i = 0; i < opts.nb_inputs; i++) {
+            sources[f][i] = quink_oc_alloc_frame(opts.height, opts.width, cv_type, layout);
+            fillFrame(sources[f][i], f, i);
+        }
+    }
+
+    std::vector<cv::Mat> buffers;
+    for (const QuinkOCFrameConfig &cfg : out_cfg)
+        buffers.push_back(quink_oc_alloc_frame(cfg.height, cfg.width, cv_type, layout));
+    std::vector<cv::Mat> outputs(buffers.size());
+
+    // Streams of a batch start at different frames of the ring
+    std::vector<std::vector<cv::Mat>> batch_buffers(opts.streams > 1 ? opts.streams : 0);
+    for (std::vector<cv::Mat> &set : batch_buffers) {
+        for (const QuinkOCFrameConfig &cfg : out_cfg)
+            set.push_back(quink_oc_alloc_frame(cfg.height, cfg.width, cv_type, layout));
+    }
+    std::vector<std::vector<cv::Mat>> batch_inputs(batch_buffers.size());
+    std::vector<std::vector<cv::Mat>> batch_outputs(batch_buffers.size());
+    std::vector<QuinkOCProcessResult> results;
+
+    // Luma proxies are built for every call, as the host does, and timed with it
+    const int proxy_scale = level >= 8 ? plugin->proxy_scale() : 0;
+    QuinkOCProxyPyramid pyramid;
+    auto addProxies = [&](std::vector<cv::Mat> &frames) {
+        for (int i = 0; i < opts.nb_inputs; i++) {
+            pyramid.set(frames[i]);
+            frames.push_back(pyramid.level(proxy_scale));
+        }
+    };
+    std::vector<cv::Mat> inputs;
+
+    // Setup leaves out the bench preparing its own frames above
+    std::vector<QuinkOCFrameConfig> warmup_out(out_cfg);
+    for (QuinkOCFrameConfig &cfg : warmup_out)
+        cfg.cv_type = cv_type;
+    const auto warmup_start = std::chrono::steady_clock::now();
+    if (opts.warmup && level >= 10)
+        plugin->warmup(in_cfg, warmup_out);
+
+    int produced = 0;
+    bool failed = false;
+    const auto start = std::chrono::steady_clock::now();
+    auto first_output = start;
+    auto output = [&]() {
+        if (produced++ == 0)
+            first_output = std::chrono::steady_clock::now();
+    };
+    auto drain = [&]() {
+        while (!failed) {
+            for (size_t i = 0; i < buffers.size(); i++)
+                outputs[i] = buffers[i];
+            if (!plugin->flush(outputs))
+                break;
+            output();
+        }
+    };
+    int resets = 0;
+    std::chrono::steady_clock::duration reset_time(0);
+    std::vector<uint8_t> state;
+    std::chrono::steady_clock::duration save_time(0), load_time(0);
+    for (int n = 0; n < opts.frames && !failed; n++) {
+        // The standby is set up in advance; taking over is loading the state
+        if (n > 0 && n == opts.handover) {
+            std::vector<QuinkOCFrameConfig> standby_out(default_out);
+            QuinkOCPlugin *standby = openPlugin(desc, level, opts, in_cfg, standby_out);
+            if (!standby) {
+                failed = true;
+                break;
+            }
+            if (opts.warmup)
+                standby->warmup(in_cfg, warmup_out);
+            const auto save_start = std::chrono::steady_clock::now();
+            const bool saved = plugin->save_state(state);
+            save_time = std::chrono::steady_clock::now() - save_start;
+            const bool refused = saved && refusesBadStates(standby, state);
+            const auto load_start = std::chrono::steady_clock::now();
+            const bool loaded = refused && standby->load_state(state.data(), state.size());
+            load_time = std::chrono::steady_clock::now() - load_start;
+            plugin->uninit();
+            desc->destroy(plugin);
+            plugin = standby;
+            if (!loaded) {
+                fprintf(stderr, "%s: %s\n", desc->name,
+                        !saved ? "save_state failed" : !refused ? "load_state accepted a bad state"
+                                                                : "load_state failed");
+                failed = true;
+                break;
+            }
+        }
+
+        // A segment ends like a stream and the next one reuses the instance
+        if (opts.segment > 0 && n > 0 && n % opts.segment == 0) {
+            drain();
+            const auto reset_start = std::chrono::steady_clock::now();
+            if (!plugin->reset()) {
+                fprintf(stderr, "%s: reset failed\n", desc->name);
+                failed = true;
+                break;
+            }
+            reset_time += std::chrono::steady_clock::now() - reset_start;
+            resets++;
+        }
+
+        if (!batch_buffers.empty()) {
+            for (size_t s = 0; s < batch_buffers.size(); s++) {
+                batch_inputs[s] = sources[(n + s) % ring];
+                if (proxy_scale > 0)
+                    addProxies(batch_inputs[s]);
+                batch_outputs[s] = batch_buffers[s];
+            }
+            if (level >= 6) {
+                plugin->process_batch(batch_inputs, batch_outputs, results);
+            } else {
+                results.resize(batch_inputs.size());
+                for (size_t s = 0; s < batch_inputs.size(); s++)
+                    results[s] = plugin->process(batch_inputs[s], batch_outputs[s]);
+            }
+            for (QuinkOCProcessResult ret : results) {
+                if (ret == QUINK_OC_ERROR)
+                    failed = true;
+                else if (ret == QUINK_OC_OK)
+                    output();
+            }
+            continue;
+        }
+
+        // The host hands out fresh buffers each call; plugins may replace
+        // an output with an input for pass-through.
+        for (size_t i = 0; i < buffers.size(); i++)
+            outputs[i] = buffers[i];
+        inputs = sources[n % ring];
+        if (proxy_scale > 0)
+            addProxies(inputs);
+        QuinkOCProcessResult ret = plugin->process(inputs, outputs);
+        if (ret == QUINK_OC_ERROR)
+            failed = true;
+        else if (ret == QUINK_OC_OK)
+            output();
+    }
+    drain();
+    const auto end = std::chrono::steady_clock::now();
+
+    plugin->uninit();
+    desc->destroy(plugin);
+    if (failed) {
+        fprintf(stderr, "%s: process failed\n", desc->name);
+        return 1;
+    }
+
+    typedef std::chrono::duration<double, std::milli> Ms;
+    const double ms = Ms(end - start).count();
+    const double setup_ms = Ms(configured - setup_start).count() + Ms(start - warmup_start).count();
+    printf("%s %dx%d cn=%d in=%d out=%d streams=%d: %d frames in %.1f ms, %.3f ms/frame, %.1f fps, "
+           "setup %.1f ms, first output %.2f ms\n",
+           desc->name, opts.width, opts.height, opts.channels, opts.nb_inputs,
+           opts.nb_outputs, opts.streams, produced, ms, produced ? ms / produced : 0.0,
+           ms > 0.0 ? produced * 1000.0 / ms : 0.0, setup_ms, Ms(first_output - start).count());
+    if (resets > 0)
+        printf("%s: %d resets, %.3f ms/reset\n", desc->name, resets, Ms(reset_time).count() / resets);
+    if (!state.empty())
+        printf("%s: state %zu bytes, save %.3f ms, load %.3f ms\n", desc->name, state.size(),
+               Ms(save_time).count(), Ms(load_time).count());
+    return 0;
+}